@@ -8,13 +8,16 @@
 
 #include "FlyBehavior.h"
 #include "QuackBehavior.h"
+#include "StrategySlot.h"
 #include <memory>
 
 class Duck {
 public:
-    // In c++ prefer unique_ptr by default, shared_ptr for a multiple references
-    std::unique_ptr<QuackBehavior> quackBehavior;
-    std::unique_ptr<FlyBehavior> flyBehavior;
+    // In c++ prefer unique_ptr by default, shared_ptr for a multiple references.
+    // Поведение можно менять из другого потока, пока утка летает или крякает,
+    // поэтому unique_ptr хранится в потокобезопасном слоте (StrategySlot.h).
+    StrategySlot<QuackBehavior> quackBehavior;
+    StrategySlot<FlyBehavior> flyBehavior;
 
     Duck(std::unique_ptr<QuackBehavior> quackBehavior,
         std::unique_ptr<FlyBehavior> flyBehavior)
@@ -23,17 +26,23 @@ public:
     {
     }
 
-    void performQuack() { quackBehavior->quack(); }
-    void performFly() { flyBehavior->fly(); }
+    // Виды уток наследуются от Duck, снимок мира (Snapshot.h) узнает вид
+    // через typeid, поэтому деструктор виртуальный
+    virtual ~Duck() = default;
 
+    void performQuack(std::ostream& out = std::cout) { quackBehavior.load()->quack(out); }
+    void performFly(std::ostream& out = std::cout) { flyBehavior.load()->fly(out); }
+
+    // Старое поведение удаляется только после того как закончатся все вызовы,
+    // которые успели его взять
     void setFlyBehavior(std::unique_ptr<FlyBehavior> flyBehavior)
     {
-        this->flyBehavior = std::move(flyBehavior);
+        this->flyBehavior.store(std::move(flyBehavior));
     }
 
     void setQuackBehavior(std::unique_ptr<QuackBehavior> quackBehavior)
     {
-        this->quackBehavior = std::move(quackBehavior);
+        this->quackBehavior.store(std::move(quackBehavior));
     }
 };
 
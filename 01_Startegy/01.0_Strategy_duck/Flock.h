@@ -0,0 +1,217 @@
+/*
+ * Параллельное выполнение поведений для большой стаи уток.
+ *
+ * Стая делится на блоки (chunk) по объему работы, а не по размеру кэша:
+ * утки и их поведения лежат в куче отдельно, поэтому "блок в L1" для
+ * std::vector<Duck*> не имеет смысла. Блок должен быть достаточно
+ * большим, чтобы окупить захват блока и его буфер вывода, и достаточно
+ * маленьким, чтобы на каждый поток пришлось несколько блоков для
+ * балансировки. Потоки пула забирают блоки по одному через атомарный
+ * счетчик, поэтому быстрые потоки сами берут больше работы:
+ *
+ *   ducks:   [ блок 0 | блок 1 | блок 2 | блок 3 | блок 4 | ... ]
+ *                 \        |        /        |
+ *              поток 0  поток 1  поток 2  главный поток
+ *
+ * Каждый блок пишет вывод в свой буфер, а не прямо в std::cout:
+ *   ORDERED   - буферы выводятся по порядку блоков после завершения всех,
+ *               результат совпадает с последовательным проходом;
+ *   UNORDERED - буфер выводится сразу, как только блок готов, блоки могут
+ *               перемешаться, но строки внутри блока не рвутся.
+ */
+#pragma once
+
+#include "Duck.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class FlockExecutor {
+public:
+    enum OutputOrder { ORDERED,
+        UNORDERED };
+
+    // Автоматический размер блока: примерно CHUNKS_PER_THREAD блоков
+    // на поток, но не меньше MIN_CHUNK уток
+    static constexpr std::size_t AUTO_CHUNK = 0;
+    static constexpr std::size_t CHUNKS_PER_THREAD = 8;
+    static constexpr std::size_t MIN_CHUNK = 256;
+
+private:
+    std::size_t _chunkSize;
+    std::vector<std::thread> _workers;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    std::function<void()> _job;
+    // Номер текущей задачи, по его изменению рабочие потоки просыпаются
+    std::uint64_t _generation = 0;
+    // Сколько рабочих потоков еще выполняют текущую задачу
+    unsigned _running = 0;
+    bool _stopping = false;
+    // Первое исключение текущей задачи, run() пробросит его вызывающему
+    std::exception_ptr _error;
+
+    void fail(std::exception_ptr error)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_error) {
+            _error = error;
+        }
+    }
+
+    void workerLoop()
+    {
+        std::uint64_t seen = 0;
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [&] { return _stopping || _generation != seen; });
+                if (_stopping) {
+                    return;
+                }
+                seen = _generation;
+                job = _job;
+            }
+            try {
+                job();
+            } catch (...) {
+                fail(std::current_exception());
+            }
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_running == 0) {
+                _done.notify_one();
+            }
+        }
+    }
+
+    // Запускает job во всех потоках пула и в вызывающем, ждет завершения.
+    // job работает с локальными переменными forEach, поэтому даже после
+    // исключения сначала дожидаемся всех потоков, и только потом бросаем.
+    void run(const std::function<void()>& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _job = job;
+            _running = static_cast<unsigned>(_workers.size());
+            _error = nullptr;
+            ++_generation;
+        }
+        _wake.notify_all();
+        try {
+            job();
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [&] { return _running == 0; });
+        _job = nullptr;
+        if (_error) {
+            std::exception_ptr error = std::exchange(_error, nullptr);
+            lock.unlock();
+            std::rethrow_exception(error);
+        }
+    }
+
+public:
+    // threads - общее число потоков вместе с вызывающим,
+    // chunkSize - уток в блоке или AUTO_CHUNK
+    explicit FlockExecutor(unsigned threads = std::thread::hardware_concurrency(),
+        std::size_t chunkSize = AUTO_CHUNK)
+        : _chunkSize(chunkSize)
+    {
+        for (unsigned i = 1; i < std::max(1u, threads); ++i) {
+            _workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~FlockExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    FlockExecutor(const FlockExecutor&) = delete;
+    FlockExecutor& operator=(const FlockExecutor&) = delete;
+
+    unsigned threads() const { return static_cast<unsigned>(_workers.size()) + 1; }
+
+    // Размер блока для стаи из count уток
+    std::size_t chunkSize(std::size_t count) const
+    {
+        if (_chunkSize != AUTO_CHUNK) {
+            return _chunkSize;
+        }
+        std::size_t perThread = (count + threads() * CHUNKS_PER_THREAD - 1)
+            / (threads() * CHUNKS_PER_THREAD);
+        return std::max(MIN_CHUNK, perThread);
+    }
+
+    // Выполняет action(duck, out) для каждой утки, вывод собирается в out
+    template <typename Action>
+    void forEach(const std::vector<Duck*>& ducks, std::ostream& out, OutputOrder order,
+        Action action)
+    {
+        std::size_t size = chunkSize(ducks.size());
+        std::size_t chunks = (ducks.size() + size - 1) / size;
+        std::atomic<std::size_t> next { 0 };
+        std::vector<std::string> buffers(order == ORDERED ? chunks : 0);
+        std::mutex outMutex;
+
+        run([&] {
+            // Один буфер на поток, между блоками только очищается
+            std::ostringstream local;
+            for (;;) {
+                std::size_t chunk = next.fetch_add(1, std::memory_order_relaxed);
+                if (chunk >= chunks) {
+                    return;
+                }
+                local.str(std::string());
+                std::size_t end = std::min(ducks.size(), (chunk + 1) * size);
+                for (std::size_t i = chunk * size; i < end; ++i) {
+                    action(*ducks[i], local);
+                }
+                if (order == ORDERED) {
+                    buffers[chunk] = local.str();
+                } else {
+                    std::lock_guard<std::mutex> lock(outMutex);
+                    out << local.view();
+                }
+            }
+        });
+
+        for (auto& buffer : buffers) {
+            out << buffer;
+        }
+    }
+
+    void performFly(const std::vector<Duck*>& ducks, std::ostream& out = std::cout,
+        OutputOrder order = ORDERED)
+    {
+        forEach(ducks, out, order, [](Duck& duck, std::ostream& local) { duck.performFly(local); });
+    }
+
+    void performQuack(const std::vector<Duck*>& ducks, std::ostream& out = std::cout,
+        OutputOrder order = ORDERED)
+    {
+        forEach(ducks, out, order,
+            [](Duck& duck, std::ostream& local) { duck.performQuack(local); });
+    }
+};
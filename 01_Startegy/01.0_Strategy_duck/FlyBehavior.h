@@ -9,8 +9,10 @@
 // Абстрактный класс с обязательной реализацией метода в наследующих классах
 class FlyBehavior {
 public:
-    // Обязательный метод для реализации =0
-    virtual void fly() const = 0;
+    // Обязательный метод для реализации =0.
+    // Поток вывода передается явно, чтобы стая могла лететь параллельно
+    // и собирать вывод каждой утки в свой буфер (Flock.h)
+    virtual void fly(std::ostream& out = std::cout) const = 0;
     // В виртуальном классе обязательно должен быть виртуальный деструктор
     virtual ~FlyBehavior() = default;
 };
@@ -18,19 +20,19 @@ public:
 // Класс в котором утки летают
 class FlyWithWings : public FlyBehavior {
 public:
-    void fly() const override { std::cout << "I'm flying!" << std::endl; }
+    void fly(std::ostream& out) const override { out << "I'm flying!" << std::endl; }
 };
 
 // Класс в котором утки не летают
 class FlyNoWay : public FlyBehavior {
-    void fly() const override { std::cout << "I can't fly" << std::endl; }
+    void fly(std::ostream& out) const override { out << "I can't fly" << std::endl; }
 };
 
 // Класс полета с ракетой
 class FlyRocketPowered : public FlyBehavior {
 public:
-    void fly() const override
+    void fly(std::ostream& out) const override
     {
-        std::cout << "I'm flying with a rocket!" << std::endl;
+        out << "I'm flying with a rocket!" << std::endl;
     }
 };
@@ -10,8 +10,8 @@
 // Абстрактный класс с обязательной реализацией метода в наследующих классах
 class QuackBehavior {
 public:
-    // Обязательный метод для реализации =0
-    virtual void quack() const = 0;
+    // Обязательный метод для реализации =0, вывод в переданный поток
+    virtual void quack(std::ostream& out = std::cout) const = 0;
     // В виртуальном базовом классе с виртуальным методом
     // обязательно должен быть виртуальный деструктор
     virtual ~QuackBehavior() = default;
@@ -20,17 +20,17 @@ public:
 // Класс в котором утки крякают
 class Quack : public QuackBehavior {
 public:
-    void quack() const override { std::cout << "Quack" << std::endl; }
+    void quack(std::ostream& out) const override { out << "Quack" << std::endl; }
 };
 
 // Класс в котором утки пищат
 class Squeak : public QuackBehavior {
 public:
-    void quack() const override { std::cout << "Squeak" << std::endl; }
+    void quack(std::ostream& out) const override { out << "Squeak" << std::endl; }
 };
 
 // Класс в котором утки не издают звуков
 class Silence : public QuackBehavior {
 public:
-    void quack() const override { std::cout << "<< Silence >>" << std::endl; }
+    void quack(std::ostream& out) const override { out << "<< Silence >>" << std::endl; }
 };
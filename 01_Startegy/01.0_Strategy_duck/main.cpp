@@ -1,4 +1,46 @@
 #include "Duck.h"
+#include "Flock.h"
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// Стая из базовых уток без вывода в конструкторах, поведения чередуются
+std::vector<std::unique_ptr<Duck>> makeFlock(std::size_t count)
+{
+    std::vector<std::unique_ptr<Duck>> flock;
+    flock.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::unique_ptr<QuackBehavior> quack;
+        std::unique_ptr<FlyBehavior> fly;
+        switch (i % 3) {
+        case 0:
+            quack = std::make_unique<Quack>();
+            fly = std::make_unique<FlyWithWings>();
+            break;
+        case 1:
+            quack = std::make_unique<Squeak>();
+            fly = std::make_unique<FlyRocketPowered>();
+            break;
+        default:
+            quack = std::make_unique<Silence>();
+            fly = std::make_unique<FlyNoWay>();
+            break;
+        }
+        flock.push_back(std::make_unique<Duck>(std::move(quack), std::move(fly)));
+    }
+    return flock;
+}
+
+std::vector<Duck*> pointers(const std::vector<std::unique_ptr<Duck>>& flock)
+{
+    std::vector<Duck*> ducks;
+    ducks.reserve(flock.size());
+    for (auto& duck : flock) {
+        ducks.push_back(duck.get());
+    }
+    return ducks;
+}
 
 int main()
 {
@@ -16,5 +58,74 @@ int main()
     modelDuck.setFlyBehavior(std::make_unique<FlyRocketPowered>());
     modelDuck.performFly();
 
+    // Меняем поведение из управляющего потока, пока другие потоки летают.
+    // Нагрузочный вариант под TSAN: 01.4_Strategy_slot_stress
+    std::cout << "\n-------- Hot swap --------" << std::endl;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 2; ++i) {
+        workers.emplace_back([&modelDuck] {
+            for (int j = 0; j < 3; ++j) {
+                modelDuck.performFly();
+            }
+        });
+    }
+    modelDuck.setFlyBehavior(std::make_unique<FlyWithWings>());
+    modelDuck.setFlyBehavior(std::make_unique<FlyNoWay>());
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Стая на пуле потоков, вывод в том же порядке, что и без потоков
+    std::cout << "\n-------- Flock --------" << std::endl;
+    auto small = makeFlock(6);
+    auto smallDucks = pointers(small);
+    FlockExecutor executor(4, 2);
+    executor.performFly(smallDucks);
+    executor.performQuack(smallDucks);
+
+    std::ostringstream sequential;
+    std::ostringstream parallel;
+    for (Duck* duck : smallDucks) {
+        duck->performFly(sequential);
+    }
+    executor.performFly(smallDucks, parallel, FlockExecutor::ORDERED);
+    std::cout << "ORDERED output matches sequential: "
+              << (sequential.str() == parallel.str()) << std::endl;
+
+    // Масштабирование от одного потока до всех ядер. Вывод уходит в пустой
+    // поток, поэтому замеряется форматирование, а не запись в терминал.
+    constexpr std::size_t COUNT = 1'000'000;
+    auto flock = makeFlock(COUNT);
+    auto ducks = pointers(flock);
+    std::ostream discard(nullptr);
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "\n" << COUNT << " ducks, fly + quack" << std::endl;
+    // 1, 2, 4, ... и все ядра
+    std::vector<unsigned> counts;
+    for (unsigned threads = 1; threads < cores; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(cores);
+
+    double baseline = 0;
+    for (unsigned threads : counts) {
+        FlockExecutor pool(threads);
+        for (auto order : { FlockExecutor::ORDERED, FlockExecutor::UNORDERED }) {
+            auto start = std::chrono::steady_clock::now();
+            pool.performFly(ducks, discard, order);
+            pool.performQuack(ducks, discard, order);
+            double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start)
+                            .count();
+            if (baseline == 0) {
+                baseline = ms;
+            }
+            std::cout << threads << " threads, chunk " << pool.chunkSize(COUNT) << " "
+                      << (order == FlockExecutor::ORDERED ? "ORDERED  " : "UNORDERED")
+                      << ": " << ms << " ms, speedup " << baseline / ms << std::endl;
+        }
+    }
+
     return 0;
 }
@@ -3,24 +3,46 @@
  */
 #pragma once
 
+#include "StrategySlot.h"
 #include "Weapon.h"
 #include <memory>
 
+// Координаты персонажа на поле боя
+struct Position {
+    float x = 0;
+    float y = 0;
+};
+
 class Character {
 public:
-    std::unique_ptr<WeaponType> weaponType;
+    // Оружие можно сменить из другого потока прямо во время боя
+    StrategySlot<WeaponType> weaponType;
+    // SpatialGrid хранит копию позиции и команды: пока персонаж в сетке,
+    // позицию меняйте только через SpatialGrid::move(), а команду не меняйте
+    Position position;
+    // Персонажи одной команды друг друга не атакуют
+    int team = 0;
+
+    // Служебные поля SpatialGrid: ячейка и место в ней, для обновления за O(1).
+    // Сетка хранит указатель, поэтому перед удалением персонажа вызовите
+    // SpatialGrid::remove()
+    int gridCell = -1;
+    std::size_t gridSlot = 0;
 
     Character(std::unique_ptr<WeaponType> weaponType)
         : weaponType(std::move(weaponType))
     {
     }
 
-    void fight() { weaponType->useWeapon(); }
+    // King, Queen и другие наследуются от Character, деструктор виртуальный
+    virtual ~Character() = default;
+
+    void fight() { weaponType.load()->useWeapon(); }
 
     void setWeapon(std::unique_ptr<WeaponType> weaponType)
     {
         std::cout << "Changing weapon" << std::endl;
-        this->weaponType = std::move(weaponType);
+        this->weaponType.store(std::move(weaponType));
     }
 };
 
@@ -0,0 +1,188 @@
+/*
+ * Равномерная сетка для поиска целей в радиусе оружия.
+ *
+ * Поле боя делится на квадратные ячейки размером cellSize, в каждой ячейке
+ * список персонажей, которые в ней стоят. Поиск цели смотрит только ячейки,
+ * которые пересекает квадрат [позиция - range, позиция + range], а не всех
+ * персонажей, поэтому выбор целей на тик стоит O(n), а не O(n^2).
+ *
+ *   +-----+-----+-----+-----+
+ *   |     |  T  |     |     |      A - лучник, range = 10
+ *   +-----+-----+-----+-----+      T - противник
+ *   |     |  A--|->T  |     |      Просматриваются только ячейки
+ *   +-----+-----+-----+-----+      вокруг A, дальние не трогаются
+ *   |     |     |     |  T  |
+ *   +-----+-----+-----+-----+
+ *
+ * Ячейка хранит копию координат и команды каждого персонажа рядом с
+ * указателем на него. Поиск идет по плотному массиву и не читает сами
+ * объекты Character, разбросанные по куче: иначе на больших армиях каждый
+ * кандидат это промах кэша, и тик растет быстрее чем O(n).
+ *
+ * Перемещение обновляет сетку инкрементально: если персонаж остался в своей
+ * ячейке, обновляется только его запись, иначе он переносится за O(1).
+ * Размер ячейки лучше брать не меньше типичной дальности оружия.
+ *
+ * Сетка хранит указатели: персонажа нужно убрать через remove() до его
+ * удаления. Пока персонаж в сетке, его позицию меняет только move(), а
+ * команду менять нельзя: иначе копия в ячейке разойдется с объектом.
+ */
+#pragma once
+
+#include "Character.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class SpatialGrid {
+private:
+    // Все, что нужно поиску, лежит прямо в ячейке
+    struct Entry {
+        float x;
+        float y;
+        int team;
+        Character* character;
+    };
+
+    float _cellSize;
+    int _columns;
+    int _rows;
+    std::vector<std::vector<Entry>> _cells;
+
+    int clampColumn(float x) const
+    {
+        return std::clamp(static_cast<int>(std::floor(x / _cellSize)), 0, _columns - 1);
+    }
+
+    int clampRow(float y) const
+    {
+        return std::clamp(static_cast<int>(std::floor(y / _cellSize)), 0, _rows - 1);
+    }
+
+    int cellOf(const Position& position) const
+    {
+        return clampRow(position.y) * _columns + clampColumn(position.x);
+    }
+
+    // Удаление из ячейки: на место персонажа ставим последнего
+    void detach(Character& character)
+    {
+        auto& cell = _cells[static_cast<std::size_t>(character.gridCell)];
+        Entry& last = cell.back();
+        last.character->gridSlot = character.gridSlot;
+        cell[character.gridSlot] = last;
+        cell.pop_back();
+        character.gridCell = -1;
+    }
+
+    void attach(Character& character, int cellIndex)
+    {
+        auto& cell = _cells[static_cast<std::size_t>(cellIndex)];
+        character.gridCell = cellIndex;
+        character.gridSlot = cell.size();
+        cell.push_back({ character.position.x, character.position.y, character.team, &character });
+    }
+
+public:
+    // Поле width x height, координаты за его пределами прижимаются к краю
+    SpatialGrid(float width, float height, float cellSize)
+        : _cellSize(cellSize)
+        , _columns(std::max(1, static_cast<int>(std::ceil(width / cellSize))))
+        , _rows(std::max(1, static_cast<int>(std::ceil(height / cellSize))))
+        , _cells(static_cast<std::size_t>(_columns * _rows))
+    {
+    }
+
+    // Повторное добавление ничего не делает: вторая запись в ячейке
+    // испортила бы gridCell и gridSlot
+    void add(Character& character)
+    {
+        if (character.gridCell >= 0) {
+            return;
+        }
+        attach(character, cellOf(character.position));
+    }
+
+    void remove(Character& character)
+    {
+        if (character.gridCell >= 0) {
+            detach(character);
+        }
+    }
+
+    // Двигаем персонажа и обновляем только его запись.
+    // Персонаж не из сетки просто получает новую позицию.
+    void move(Character& character, const Position& position)
+    {
+        character.position = position;
+        if (character.gridCell < 0) {
+            return;
+        }
+        int cellIndex = cellOf(position);
+        if (cellIndex != character.gridCell) {
+            detach(character);
+            attach(character, cellIndex);
+            return;
+        }
+        Entry& entry = _cells[static_cast<std::size_t>(cellIndex)][character.gridSlot];
+        entry.x = position.x;
+        entry.y = position.y;
+    }
+
+    // Ближайший противник в радиусе range или nullptr
+    Character* nearestEnemy(const Character& self, float range) const
+    {
+        return nearestEnemy(self.position, self.team, range);
+    }
+
+    Character* nearestEnemy(const Position& center, int team, float range) const
+    {
+        int columnFrom = clampColumn(center.x - range);
+        int columnTo = clampColumn(center.x + range);
+        int rowFrom = clampRow(center.y - range);
+        int rowTo = clampRow(center.y + range);
+
+        Character* nearest = nullptr;
+        float best = range * range;
+        for (int row = rowFrom; row <= rowTo; ++row) {
+            for (int column = columnFrom; column <= columnTo; ++column) {
+                for (const Entry& other : _cells[static_cast<std::size_t>(row * _columns + column)]) {
+                    if (other.team == team) {
+                        continue;
+                    }
+                    float dx = other.x - center.x;
+                    float dy = other.y - center.y;
+                    float distance = dx * dx + dy * dy;
+                    if (distance <= best) {
+                        best = distance;
+                        nearest = other.character;
+                    }
+                }
+            }
+        }
+        return nearest;
+    }
+
+    // Выбор целей для всех персонажей за один проход по ячейкам:
+    // function(персонаж, цель или nullptr). Соседи по ячейке ищут цели в
+    // одних и тех же ячейках, поэтому такой порядок бережет кэш. Позиция и
+    // команда берутся из записи ячейки, Character читается только ради оружия.
+    template <typename Function>
+    void forEachTarget(Function function) const
+    {
+        for (auto& cell : _cells) {
+            for (const Entry& entry : cell) {
+                float range = entry.character->weaponType.load()->range();
+                function(*entry.character,
+                    nearestEnemy(Position { entry.x, entry.y }, entry.team, range));
+            }
+        }
+    }
+
+    // Цель для персонажа в радиусе его текущего оружия: стратегия оружия
+    // сама определяет, насколько далеко можно искать
+    Character* findTarget(const Character& self) const
+    {
+        return nearestEnemy(self, self.weaponType.load()->range());
+    }
+};
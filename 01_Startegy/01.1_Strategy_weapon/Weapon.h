@@ -9,6 +9,9 @@
 class WeaponType {
 public:
     virtual void useWeapon() const = 0;
+    // Дальность, на которой оружие достает цель. По ней SpatialGrid
+    // ищет противников в радиусе.
+    virtual float range() const { return 1.0f; }
     virtual ~WeaponType() = default;
 };
 
@@ -17,6 +20,8 @@ class SwordBehavior : public WeaponType {
     {
         std::cout << "I'm fighting with sword!" << std::endl;
     }
+
+    float range() const override { return 1.5f; }
 };
 
 class KnifeBehavior : public WeaponType {
@@ -24,6 +29,8 @@ class KnifeBehavior : public WeaponType {
     {
         std::cout << "I'm fighting with sword!" << std::endl;
     }
+
+    float range() const override { return 1.0f; }
 };
 
 class BowAndArrowBehavior : public WeaponType {
@@ -31,6 +38,8 @@ class BowAndArrowBehavior : public WeaponType {
     {
         std::cout << "I'm shooting with bow!" << std::endl;
     }
+
+    float range() const override { return 10.0f; }
 };
 
 class AxeBehavior : public WeaponType {
@@ -38,4 +47,6 @@ class AxeBehavior : public WeaponType {
     {
         std::cout << "I'm fighting with axe!" << std::endl;
     }
+
+    float range() const override { return 2.0f; }
 };
@@ -1,5 +1,135 @@
 #include "Character.h"
+#include "SpatialGrid.h"
 #include "Weapon.h"
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Поиск цели перебором всех персонажей, для сравнения с SpatialGrid
+Character* naiveTarget(const Character& self, const std::vector<Character*>& all)
+{
+    float range = self.weaponType.load()->range();
+    Character* nearest = nullptr;
+    float best = range * range;
+    for (Character* other : all) {
+        if (other->team == self.team) {
+            continue;
+        }
+        float dx = other->position.x - self.position.x;
+        float dy = other->position.y - self.position.y;
+        float distance = dx * dx + dy * dy;
+        if (distance <= best) {
+            best = distance;
+            nearest = other;
+        }
+    }
+    return nearest;
+}
+
+// Один тик боя: каждый персонаж выбирает цель, возвращает число найденных целей
+template <typename FindTarget>
+std::size_t tick(const std::vector<Character*>& all, FindTarget findTarget)
+{
+    std::size_t found = 0;
+    for (Character* character : all) {
+        if (findTarget(*character)) {
+            ++found;
+        }
+    }
+    return found;
+}
+
+// Армия без вывода в конструкторах: лучники и бойцы ближнего боя
+// двух команд, случайно расставленные на поле side x side
+std::vector<std::unique_ptr<Character>> makeArmy(std::size_t count, float side)
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coordinate(0.0f, side);
+    std::vector<std::unique_ptr<Character>> army;
+    army.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::unique_ptr<WeaponType> weapon;
+        switch (i % 3) {
+        case 0:
+            weapon = std::make_unique<BowAndArrowBehavior>();
+            break;
+        case 1:
+            weapon = std::make_unique<SwordBehavior>();
+            break;
+        default:
+            weapon = std::make_unique<AxeBehavior>();
+            break;
+        }
+        auto character = std::make_unique<Character>(std::move(weapon));
+        character->team = static_cast<int>(i % 2);
+        character->position = { coordinate(random), coordinate(random) };
+        army.push_back(std::move(character));
+    }
+    return army;
+}
+
+template <typename Function>
+double measureMs(Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+void battleBenchmark(std::size_t count)
+{
+    // Плотность постоянна: в среднем 1 персонаж на 4 клетки поля
+    float side = std::sqrt(static_cast<float>(count) * 4.0f);
+    auto army = makeArmy(count, side);
+    std::vector<Character*> all;
+    for (auto& character : army) {
+        all.push_back(character.get());
+    }
+
+    SpatialGrid grid(side, side, 10.0f);
+    for (Character* character : all) {
+        grid.add(*character);
+    }
+
+    // Все делают шаг, сетка обновляется только для сменивших ячейку
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+    double moveMs = measureMs([&] {
+        for (Character* character : all) {
+            grid.move(*character,
+                { character->position.x + step(random), character->position.y + step(random) });
+        }
+    });
+
+    // Тик по сетке обходит персонажей в порядке ячеек
+    std::size_t gridFound = 0;
+    double gridMs = measureMs([&] {
+        grid.forEachTarget([&](const Character&, const Character* target) {
+            if (target) {
+                ++gridFound;
+            }
+        });
+    });
+
+    std::cout << count << " units: grid tick " << gridMs << " ms ("
+              << gridMs * 1e6 / static_cast<double>(count) << " ns/unit), move " << moveMs
+              << " ms, targets " << gridFound;
+
+    // Перебор O(n^2) замеряем только на небольших армиях
+    if (count <= 20'000) {
+        std::size_t naiveFound = 0;
+        double naiveMs = measureMs([&] {
+            naiveFound = tick(all, [&](const Character& self) { return naiveTarget(self, all); });
+        });
+        std::cout << "; naive tick " << naiveMs << " ms, targets " << naiveFound
+                  << (naiveFound == gridFound ? " (match)" : " (MISMATCH)");
+    }
+    std::cout << std::endl;
+}
 
 int main()
 {
@@ -18,5 +148,45 @@ int main()
     troll.setWeapon(std::make_unique<KnifeBehavior>());
     troll.fight();
 
+    // Оружие меняется из управляющего потока прямо во время боя.
+    // Нагрузочный вариант под TSAN: 01.4_Strategy_slot_stress
+    std::thread fighter([&troll] {
+        for (int i = 0; i < 3; ++i) {
+            troll.fight();
+        }
+    });
+    troll.setWeapon(std::make_unique<SwordBehavior>());
+    fighter.join();
+
+    // Бой на поле: лучник стреляет дальше, чем бьет меч
+    std::cout << "\n--------- Battle ---------" << std::endl;
+    SpatialGrid field(20.0f, 20.0f, 10.0f);
+    king.team = 0;
+    king.position = { 2.0f, 2.0f };
+    queen.team = 0;
+    queen.position = { 3.0f, 2.0f };
+    queen.setWeapon(std::make_unique<BowAndArrowBehavior>());
+    troll.team = 1;
+    troll.position = { 9.0f, 2.0f };
+    field.add(king);
+    field.add(queen);
+    field.add(troll);
+
+    std::cout << "King sees troll: " << (field.findTarget(king) == &troll) << std::endl;
+    std::cout << "Queen sees troll: " << (field.findTarget(queen) == &troll) << std::endl;
+    field.move(troll, { 3.5f, 2.5f });
+    std::cout << "Troll moved closer, King sees troll: " << (field.findTarget(king) == &troll)
+              << std::endl;
+    if (Character* target = field.findTarget(troll)) {
+        std::cout << "Troll attacks " << (target == &king ? "King" : "Queen") << ": ";
+        troll.fight();
+    }
+
+    // Замер выбора целей на один тик
+    std::cout << std::endl;
+    for (std::size_t count : { 2'000, 20'000, 200'000, 2'000'000 }) {
+        battleBenchmark(count);
+    }
+
     return 0;
 }
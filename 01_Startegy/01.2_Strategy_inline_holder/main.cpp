@@ -0,0 +1,126 @@
+/*
+ * Сравнение InlineStrategy (встроенный буфер) и std::unique_ptr для
+ * хранения стратегий: создание, замена поведения и вызов.
+ * Замер имеет смысл в Release сборке:
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release
+ */
+#include "FlyBehavior.h"
+#include "InlineStrategy.h"
+#include "QuackBehavior.h"
+#include "Weapon.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Поведения "из плагина", о которых FlyBehavior.h ничего не знает.
+// Ничего не печатают, чтобы в замере был виден только вызов.
+std::uint64_t flights = 0;
+
+class CountingFly : public FlyBehavior {
+public:
+    void fly(std::ostream&) const override { ++flights; }
+};
+
+class GlidingFly : public FlyBehavior {
+public:
+    void fly(std::ostream&) const override { flights += 2; }
+};
+
+// Поведение с большим состоянием не помещается в буфер и уходит в кучу
+class RecordingFly : public FlyBehavior {
+private:
+    char _log[256] = {};
+
+public:
+    void fly(std::ostream& out) const override
+    {
+        out << "I'm flying and recording " << sizeof(_log) << " bytes"
+            << std::endl;
+    }
+};
+
+template <typename Function>
+double measure(Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+int main()
+{
+    // Маленькие поведения лежат прямо в объекте
+    InlineStrategy<FlyBehavior> flyBehavior = FlyWithWings();
+    flyBehavior->fly();
+    std::cout << "FlyWithWings inline: " << flyBehavior.isInline() << std::endl;
+
+    InlineStrategy<QuackBehavior> quackBehavior = InlineStrategy<QuackBehavior>::make<Squeak>();
+    quackBehavior->quack();
+
+    InlineStrategy<WeaponType> weaponType = AxeBehavior();
+    weaponType->useWeapon();
+
+    // Старый код с make_unique продолжает компилироваться, объект остается в куче
+    flyBehavior = std::make_unique<FlyRocketPowered>();
+    flyBehavior->fly();
+    std::cout << "FlyRocketPowered from unique_ptr inline: " << flyBehavior.isInline()
+              << std::endl;
+
+    flyBehavior = RecordingFly();
+    flyBehavior->fly();
+    std::cout << "RecordingFly inline: " << flyBehavior.isInline() << std::endl;
+
+    // Замер на миллионе объектов
+    constexpr std::size_t COUNT = 1'000'000;
+    std::cout << "\nBenchmark, ns per object (unique_ptr / InlineStrategy)" << std::endl;
+
+    std::vector<std::unique_ptr<FlyBehavior>> pointers;
+    std::vector<InlineStrategy<FlyBehavior>> holders;
+    pointers.reserve(COUNT);
+    holders.reserve(COUNT);
+
+    double pointerBuild = measure([&] {
+        for (std::size_t i = 0; i < COUNT; ++i) {
+            pointers.push_back(std::make_unique<CountingFly>());
+        }
+    });
+    double holderBuild = measure([&] {
+        for (std::size_t i = 0; i < COUNT; ++i) {
+            holders.push_back(CountingFly());
+        }
+    });
+    std::cout << "construct: " << pointerBuild / COUNT << " / " << holderBuild / COUNT
+              << std::endl;
+
+    double pointerSwap = measure([&] {
+        for (auto& pointer : pointers) {
+            pointer = std::make_unique<GlidingFly>();
+        }
+    });
+    double holderSwap = measure([&] {
+        for (auto& holder : holders) {
+            holder = GlidingFly();
+        }
+    });
+    std::cout << "swap:      " << pointerSwap / COUNT << " / " << holderSwap / COUNT
+              << std::endl;
+
+    double pointerCall = measure([&] {
+        for (auto& pointer : pointers) {
+            pointer->fly();
+        }
+    });
+    double holderCall = measure([&] {
+        for (auto& holder : holders) {
+            holder->fly();
+        }
+    });
+    std::cout << "call:      " << pointerCall / COUNT << " / " << holderCall / COUNT
+              << std::endl;
+    std::cout << "flights " << flights << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,539 @@
+/*
+ * Компактный двоичный снимок мира уток и персонажей.
+ *
+ * Для каждого объекта сохраняется его тип (MallardDuck, King, ...) и то,
+ * какие стратегии он сейчас держит. Значения хранятся по столбцам, как в
+ * колоночных БД: сначала типы всех уток, затем их полеты, затем кряканье.
+ * Каждый столбец читается подряд, а одинаковые значения лежат рядом.
+ *
+ *   +--------+------------------------------+
+ *   | Header | SNAP, версия, число объектов |
+ *   +--------+------------------------------+
+ *   | Словари: имена типов и стратегий,     |  id в столбцах -> имя, поэтому
+ *   | по одному на каждый столбец с id      |  порядок регистрации может
+ *   +---------------------------------------+  меняться между версиями
+ *   | duck kind    uint8[duckCount]         |
+ *   | duck fly     uint8[duckCount]         |
+ *   | duck quack   uint8[duckCount]         |
+ *   | char kind    uint8[characterCount]    |
+ *   | char weapon  uint8[characterCount]    |
+ *   | char team    int32[characterCount]    |
+ *   | char x, y    float[characterCount] x2 |
+ *   +---------------------------------------+
+ *   Каждая секция выровнена на 8 байт. Порядок байт little-endian.
+ *
+ * Загрузчик отображает файл в память (mmap) и за один проход по столбцам
+ * создает объекты. Конструкторы MallardDuck(), King() и setWeapon() не
+ * вызываются: имена из словарей один раз переводятся в таблицу фабрик,
+ * дальше на объект приходится только выбор фабрики по индексу.
+ */
+#pragma once
+
+#include "Character.h"
+#include "Duck.h"
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(std::endian::native == std::endian::little,
+    "Snapshot format is little-endian");
+
+// Таблица типов одной иерархии: имя для файла, тип для сохранения
+// и фабрика для загрузки. id типа это его номер в таблице.
+template <typename Base>
+class TypeTable {
+    static_assert(std::has_virtual_destructor_v<Base>,
+        "TypeTable needs a polymorphic base to find the dynamic type");
+
+public:
+    typedef std::unique_ptr<Base> (*Factory)();
+
+private:
+    struct Entry {
+        std::string name;
+        std::type_index type;
+        Factory make;
+    };
+
+    std::vector<Entry> _entries;
+
+public:
+    // Фабрика есть только у типов с конструктором по умолчанию:
+    // Duck и Character без стратегий создать нельзя
+    template <typename Derived>
+    TypeTable& add(const std::string& name)
+    {
+        static_assert(std::is_base_of_v<Base, Derived>);
+        if (_entries.size() >= 0xFF) {
+            throw std::length_error("TypeTable holds at most 255 types");
+        }
+        // Длина имени в словаре файла занимает один байт
+        if (name.size() > 0xFF) {
+            throw std::length_error("type name is longer than 255 bytes: " + name);
+        }
+        Factory make = nullptr;
+        if constexpr (std::is_default_constructible_v<Derived>) {
+            make = []() -> std::unique_ptr<Base> { return std::make_unique<Derived>(); };
+        }
+        _entries.push_back({ name, std::type_index(typeid(Derived)), make });
+        return *this;
+    }
+
+    std::size_t size() const { return _entries.size(); }
+    const std::string& name(std::uint8_t id) const { return _entries.at(id).name; }
+    Factory factory(std::uint8_t id) const { return _entries.at(id).make; }
+
+    // id динамического типа объекта
+    std::uint8_t idOf(const Base& object) const
+    {
+        std::type_index type(typeid(object));
+        for (std::size_t id = 0; id < _entries.size(); ++id) {
+            if (_entries[id].type == type) {
+                return static_cast<std::uint8_t>(id);
+            }
+        }
+        throw std::runtime_error(std::string("type is not registered: ") + type.name());
+    }
+
+    int find(const std::string& name) const
+    {
+        for (std::size_t id = 0; id < _entries.size(); ++id) {
+            if (_entries[id].name == name) {
+                return static_cast<int>(id);
+            }
+        }
+        return -1;
+    }
+};
+
+// Все типы, которые могут встретиться в снимке
+struct SnapshotRegistry {
+    TypeTable<Duck> duckKinds;
+    TypeTable<FlyBehavior> fly;
+    TypeTable<QuackBehavior> quack;
+    TypeTable<Character> characterKinds;
+    TypeTable<WeaponType> weapons;
+
+    // Типы из примеров 01.0 и 01.1
+    static SnapshotRegistry standard()
+    {
+        SnapshotRegistry registry;
+        registry.duckKinds.add<Duck>("Duck").add<MallardDuck>("MallardDuck").add<ModelDuck>("ModelDuck");
+        registry.fly.add<FlyWithWings>("FlyWithWings")
+            .add<FlyNoWay>("FlyNoWay")
+            .add<FlyRocketPowered>("FlyRocketPowered");
+        registry.quack.add<Quack>("Quack").add<Squeak>("Squeak").add<Silence>("Silence");
+        registry.characterKinds.add<Character>("Character")
+            .add<King>("King")
+            .add<Queen>("Queen")
+            .add<Troll>("Troll")
+            .add<Knight>("Knight");
+        registry.weapons.add<SwordBehavior>("SwordBehavior")
+            .add<KnifeBehavior>("KnifeBehavior")
+            .add<BowAndArrowBehavior>("BowAndArrowBehavior")
+            .add<AxeBehavior>("AxeBehavior");
+        return registry;
+    }
+};
+
+// Восстановленный мир. Объекты создаются как базовые Duck и Character,
+// их вид хранится рядом в виде id из SnapshotRegistry.
+// deque не перемещает объекты при росте, а Duck и Character не перемещаемы.
+struct World {
+    std::deque<Duck> ducks;
+    std::vector<std::uint8_t> duckKinds;
+    std::deque<Character> characters;
+    std::vector<std::uint8_t> characterKinds;
+};
+
+class Snapshot {
+private:
+    static constexpr char MAGIC[4] = { 'S', 'N', 'A', 'P' };
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::size_t ALIGNMENT = 8;
+
+    struct Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t duckCount;
+        std::uint64_t characterCount;
+    };
+    static_assert(sizeof(Header) == 24 && std::is_trivially_copyable_v<Header>);
+
+    // ---------------------------------------------------------------------
+    // Запись
+    // ---------------------------------------------------------------------
+    class Writer {
+    private:
+        std::ofstream _out;
+        std::size_t _offset = 0;
+
+    public:
+        explicit Writer(const std::string& path)
+            : _out(path, std::ios::binary | std::ios::trunc)
+        {
+            if (!_out) {
+                throw std::system_error(errno, std::generic_category(), path);
+            }
+        }
+
+        void write(const void* data, std::size_t bytes)
+        {
+            _out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            _offset += bytes;
+        }
+
+        void align()
+        {
+            static const char zeros[ALIGNMENT] = {};
+            write(zeros, (ALIGNMENT - _offset % ALIGNMENT) % ALIGNMENT);
+        }
+
+        template <typename T>
+        void column(const std::vector<T>& values)
+        {
+            write(values.data(), values.size() * sizeof(T));
+            align();
+        }
+
+        template <typename Base>
+        void dictionary(const TypeTable<Base>& table)
+        {
+            std::uint8_t count = static_cast<std::uint8_t>(table.size());
+            write(&count, 1);
+            for (std::size_t id = 0; id < table.size(); ++id) {
+                // Длину имени проверяет TypeTable::add()
+                const std::string& name = table.name(static_cast<std::uint8_t>(id));
+                std::uint8_t length = static_cast<std::uint8_t>(name.size());
+                write(&length, 1);
+                write(name.data(), length);
+            }
+        }
+
+        void close()
+        {
+            _out.close();
+            if (!_out) {
+                throw std::runtime_error("failed to write snapshot");
+            }
+        }
+    };
+
+    static void write(const std::string& path,
+        const std::vector<const Duck*>& ducks, const std::vector<std::uint8_t>& duckKinds,
+        const std::vector<const Character*>& characters,
+        const std::vector<std::uint8_t>& characterKinds, const SnapshotRegistry& registry)
+    {
+        // Столбцы пишутся подряд без разделителей: столбец другой длины
+        // сдвинул бы все следующие, поэтому проверяем до открытия файла
+        if (duckKinds.size() != ducks.size()) {
+            throw std::runtime_error("snapshot has " + std::to_string(ducks.size())
+                + " ducks but " + std::to_string(duckKinds.size()) + " duck kinds");
+        }
+        if (characterKinds.size() != characters.size()) {
+            throw std::runtime_error("snapshot has " + std::to_string(characters.size())
+                + " characters but " + std::to_string(characterKinds.size())
+                + " character kinds");
+        }
+
+        // Сначала раскладываем объекты по столбцам
+        std::vector<std::uint8_t> fly(ducks.size());
+        std::vector<std::uint8_t> quack(ducks.size());
+        for (std::size_t i = 0; i < ducks.size(); ++i) {
+            fly[i] = registry.fly.idOf(*ducks[i]->flyBehavior.load());
+            quack[i] = registry.quack.idOf(*ducks[i]->quackBehavior.load());
+        }
+
+        std::vector<std::uint8_t> weapon(characters.size());
+        std::vector<std::int32_t> team(characters.size());
+        std::vector<float> x(characters.size());
+        std::vector<float> y(characters.size());
+        for (std::size_t i = 0; i < characters.size(); ++i) {
+            weapon[i] = registry.weapons.idOf(*characters[i]->weaponType.load());
+            team[i] = characters[i]->team;
+            x[i] = characters[i]->position.x;
+            y[i] = characters[i]->position.y;
+        }
+
+        Writer writer(path);
+        Header header {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.duckCount = ducks.size();
+        header.characterCount = characters.size();
+        writer.write(&header, sizeof(header));
+
+        writer.dictionary(registry.duckKinds);
+        writer.dictionary(registry.fly);
+        writer.dictionary(registry.quack);
+        writer.dictionary(registry.characterKinds);
+        writer.dictionary(registry.weapons);
+        writer.align();
+
+        writer.column(duckKinds);
+        writer.column(fly);
+        writer.column(quack);
+        writer.column(characterKinds);
+        writer.column(weapon);
+        writer.column(team);
+        writer.column(x);
+        writer.column(y);
+        writer.close();
+    }
+
+    // ---------------------------------------------------------------------
+    // Чтение
+    // ---------------------------------------------------------------------
+
+    // Файл, отображенный в память только для чтения
+    class MappedFile {
+    private:
+        const unsigned char* _data = nullptr;
+        std::size_t _size = 0;
+
+    public:
+        explicit MappedFile(const std::string& path)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), path);
+            }
+            struct stat info;
+            if (::fstat(fd, &info) != 0) {
+                int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "fstat");
+            }
+            _size = static_cast<std::size_t>(info.st_size);
+            if (_size == 0) {
+                ::close(fd);
+                throw std::runtime_error(path + " is empty");
+            }
+            void* data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            int error = errno;
+            // Отображение держит файл само, дескриптор больше не нужен
+            ::close(fd);
+            if (data == MAP_FAILED) {
+                throw std::system_error(error, std::generic_category(), "mmap");
+            }
+            // Столбцы читаются подряд: ядро может читать страницы заранее
+            ::madvise(data, _size, MADV_SEQUENTIAL);
+            _data = static_cast<const unsigned char*>(data);
+        }
+
+        ~MappedFile() { ::munmap(const_cast<unsigned char*>(_data), _size); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const unsigned char* data() const { return _data; }
+        std::size_t size() const { return _size; }
+    };
+
+    // Курсор по отображенному файлу с проверкой границ
+    class Reader {
+    private:
+        const unsigned char* _data;
+        std::size_t _size;
+        std::size_t _offset = 0;
+
+        const unsigned char* take(std::size_t bytes)
+        {
+            if (bytes > _size - _offset) {
+                throw std::runtime_error("snapshot is truncated");
+            }
+            const unsigned char* pointer = _data + _offset;
+            _offset += bytes;
+            return pointer;
+        }
+
+    public:
+        Reader(const unsigned char* data, std::size_t size)
+            : _data(data)
+            , _size(size)
+        {
+        }
+
+        template <typename T>
+        T read()
+        {
+            T value;
+            std::memcpy(&value, take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        void align()
+        {
+            take((ALIGNMENT - _offset % ALIGNMENT) % ALIGNMENT);
+        }
+
+        template <typename T>
+        const unsigned char* column(std::uint64_t count)
+        {
+            if (count > _size / sizeof(T)) {
+                throw std::runtime_error("snapshot is truncated");
+            }
+            const unsigned char* pointer = take(static_cast<std::size_t>(count) * sizeof(T));
+            align();
+            return pointer;
+        }
+
+        // Словарь файла -> id в таблице этой программы
+        template <typename Base>
+        std::vector<std::uint8_t> dictionary(const TypeTable<Base>& table)
+        {
+            std::uint8_t count = read<std::uint8_t>();
+            std::vector<std::uint8_t> remap(count);
+            for (auto& id : remap) {
+                std::uint8_t length = read<std::uint8_t>();
+                std::string name(reinterpret_cast<const char*>(take(length)), length);
+                int local = table.find(name);
+                if (local < 0) {
+                    throw std::runtime_error("snapshot uses unknown type " + name);
+                }
+                id = static_cast<std::uint8_t>(local);
+            }
+            return remap;
+        }
+    };
+
+    // Столбцы не обязаны быть выровнены под T, поэтому чтение через memcpy
+    template <typename T>
+    static T at(const unsigned char* column, std::size_t index)
+    {
+        T value;
+        std::memcpy(&value, column + index * sizeof(T), sizeof(T));
+        return value;
+    }
+
+    static std::uint8_t checked(const std::vector<std::uint8_t>& remap, std::uint8_t id)
+    {
+        if (id >= remap.size()) {
+            throw std::runtime_error("snapshot has an id outside its dictionary");
+        }
+        return remap[id];
+    }
+
+    // Фабрики в порядке id файла, чтобы не переводить id на каждом объекте
+    template <typename Base>
+    static std::vector<typename TypeTable<Base>::Factory> factories(
+        const TypeTable<Base>& table, const std::vector<std::uint8_t>& remap)
+    {
+        std::vector<typename TypeTable<Base>::Factory> result;
+        for (std::uint8_t local : remap) {
+            auto make = table.factory(local);
+            if (!make) {
+                throw std::runtime_error(table.name(local) + " cannot be created by a snapshot");
+            }
+            result.push_back(make);
+        }
+        return result;
+    }
+
+public:
+    // Сохранение живых объектов: вид определяется по динамическому типу
+    static void save(const std::string& path, const std::vector<const Duck*>& ducks,
+        const std::vector<const Character*>& characters,
+        const SnapshotRegistry& registry = SnapshotRegistry::standard())
+    {
+        std::vector<std::uint8_t> duckKinds;
+        duckKinds.reserve(ducks.size());
+        for (const Duck* duck : ducks) {
+            duckKinds.push_back(registry.duckKinds.idOf(*duck));
+        }
+        std::vector<std::uint8_t> characterKinds;
+        characterKinds.reserve(characters.size());
+        for (const Character* character : characters) {
+            characterKinds.push_back(registry.characterKinds.idOf(*character));
+        }
+        write(path, ducks, duckKinds, characters, characterKinds, registry);
+    }
+
+    // Сохранение ранее загруженного мира, виды берутся из World
+    static void save(const std::string& path, const World& world,
+        const SnapshotRegistry& registry = SnapshotRegistry::standard())
+    {
+        std::vector<const Duck*> ducks;
+        ducks.reserve(world.ducks.size());
+        for (const Duck& duck : world.ducks) {
+            ducks.push_back(&duck);
+        }
+        std::vector<const Character*> characters;
+        characters.reserve(world.characters.size());
+        for (const Character& character : world.characters) {
+            characters.push_back(&character);
+        }
+        write(path, ducks, world.duckKinds, characters, world.characterKinds, registry);
+    }
+
+    static World load(const std::string& path,
+        const SnapshotRegistry& registry = SnapshotRegistry::standard())
+    {
+        MappedFile file(path);
+        Reader reader(file.data(), file.size());
+
+        Header header = reader.read<Header>();
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error(path + " is not a snapshot");
+        }
+        if (header.version != VERSION) {
+            throw std::runtime_error(path + " has unsupported version");
+        }
+
+        auto duckKindIds = reader.dictionary(registry.duckKinds);
+        auto flyMake = factories(registry.fly, reader.dictionary(registry.fly));
+        auto quackMake = factories(registry.quack, reader.dictionary(registry.quack));
+        auto characterKindIds = reader.dictionary(registry.characterKinds);
+        auto weaponMake = factories(registry.weapons, reader.dictionary(registry.weapons));
+        reader.align();
+
+        std::uint64_t duckCount = header.duckCount;
+        std::uint64_t characterCount = header.characterCount;
+        const unsigned char* duckKind = reader.column<std::uint8_t>(duckCount);
+        const unsigned char* fly = reader.column<std::uint8_t>(duckCount);
+        const unsigned char* quack = reader.column<std::uint8_t>(duckCount);
+        const unsigned char* characterKind = reader.column<std::uint8_t>(characterCount);
+        const unsigned char* weapon = reader.column<std::uint8_t>(characterCount);
+        const unsigned char* team = reader.column<std::int32_t>(characterCount);
+        const unsigned char* x = reader.column<float>(characterCount);
+        const unsigned char* y = reader.column<float>(characterCount);
+
+        World world;
+        world.duckKinds.resize(duckCount);
+        for (std::size_t i = 0; i < duckCount; ++i) {
+            world.duckKinds[i] = checked(duckKindIds, duckKind[i]);
+            if (fly[i] >= flyMake.size() || quack[i] >= quackMake.size()) {
+                throw std::runtime_error("snapshot has an id outside its dictionary");
+            }
+            world.ducks.emplace_back(quackMake[quack[i]](), flyMake[fly[i]]());
+        }
+
+        world.characterKinds.resize(characterCount);
+        for (std::size_t i = 0; i < characterCount; ++i) {
+            world.characterKinds[i] = checked(characterKindIds, characterKind[i]);
+            if (weapon[i] >= weaponMake.size()) {
+                throw std::runtime_error("snapshot has an id outside its dictionary");
+            }
+            Character& character = world.characters.emplace_back(weaponMake[weapon[i]]());
+            character.team = at<std::int32_t>(team, i);
+            character.position = { at<float>(x, i), at<float>(y, i) };
+        }
+        return world;
+    }
+};
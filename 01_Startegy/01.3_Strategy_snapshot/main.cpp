@@ -0,0 +1,94 @@
+/*
+ * Сохранение и восстановление мира уток и персонажей через Snapshot.h.
+ * Замер имеет смысл в Release сборке:
+ *   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release
+ */
+#include "Snapshot.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+template <typename Function>
+double measureMs(Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+int main()
+{
+    SnapshotRegistry registry = SnapshotRegistry::standard();
+    std::string path = (std::filesystem::temp_directory_path() / "strategy_world.snap").string();
+
+    // Небольшой мир из настоящих MallardDuck, King и т.д.
+    MallardDuck mallardDuck;
+    ModelDuck modelDuck;
+    modelDuck.setFlyBehavior(std::make_unique<FlyRocketPowered>());
+    King king;
+    Troll troll;
+    troll.setWeapon(std::make_unique<BowAndArrowBehavior>());
+    troll.team = 1;
+    troll.position = { 5.0f, 2.5f };
+
+    Snapshot::save(path, { &mallardDuck, &modelDuck }, { &king, &troll }, registry);
+    std::cout << "\nSaved " << std::filesystem::file_size(path) << " bytes" << std::endl;
+
+    // Объекты восстанавливаются без конструкторов MallardDuck() и King()
+    World world = Snapshot::load(path, registry);
+    for (std::size_t i = 0; i < world.ducks.size(); ++i) {
+        std::cout << registry.duckKinds.name(world.duckKinds[i]) << ": ";
+        world.ducks[i].performFly();
+    }
+    for (std::size_t i = 0; i < world.characters.size(); ++i) {
+        const Character& character = world.characters[i];
+        std::cout << registry.characterKinds.name(world.characterKinds[i]) << " team "
+                  << character.team << " at (" << character.position.x << ", "
+                  << character.position.y << "): ";
+        character.weaponType.load()->useWeapon();
+    }
+
+    // Миллион уток и миллион персонажей
+    constexpr std::size_t COUNT = 1'000'000;
+    World big;
+    for (std::size_t i = 0; i < COUNT; ++i) {
+        big.ducks.emplace_back(registry.quack.factory(static_cast<std::uint8_t>(i % 3))(),
+            registry.fly.factory(static_cast<std::uint8_t>(i % 2))());
+        big.duckKinds.push_back(static_cast<std::uint8_t>(1 + i % 2));
+        Character& character = big.characters.emplace_back(
+            registry.weapons.factory(static_cast<std::uint8_t>(i % 4))());
+        character.team = static_cast<int>(i % 2);
+        character.position = { static_cast<float>(i % 1000), static_cast<float>(i / 1000) };
+        big.characterKinds.push_back(static_cast<std::uint8_t>(1 + i % 4));
+    }
+
+    double saveMs = measureMs([&] { Snapshot::save(path, big, registry); });
+    World restored;
+    double loadMs = measureMs([&] { restored = Snapshot::load(path, registry); });
+
+    // Проверяем, что стратегии и координаты восстановились
+    bool same = restored.ducks.size() == COUNT && restored.characters.size() == COUNT;
+    for (std::size_t i = 0; same && i < COUNT; ++i) {
+        same = restored.duckKinds[i] == big.duckKinds[i]
+            && registry.fly.idOf(*restored.ducks[i].flyBehavior.load())
+                == registry.fly.idOf(*big.ducks[i].flyBehavior.load())
+            && registry.quack.idOf(*restored.ducks[i].quackBehavior.load())
+                == registry.quack.idOf(*big.ducks[i].quackBehavior.load())
+            && restored.characterKinds[i] == big.characterKinds[i]
+            && registry.weapons.idOf(*restored.characters[i].weaponType.load())
+                == registry.weapons.idOf(*big.characters[i].weaponType.load())
+            && restored.characters[i].team == big.characters[i].team
+            && restored.characters[i].position.x == big.characters[i].position.x
+            && restored.characters[i].position.y == big.characters[i].position.y;
+    }
+
+    std::cout << "\n" << COUNT << " ducks + " << COUNT << " characters: "
+              << std::filesystem::file_size(path) << " bytes, save " << saveMs
+              << " ms, load " << loadMs << " ms (" << loadMs * 1e6 / (2 * COUNT)
+              << " ns/object), restored " << (same ? "identical" : "DIFFERENT") << std::endl;
+
+    std::remove(path.c_str());
+    return 0;
+}
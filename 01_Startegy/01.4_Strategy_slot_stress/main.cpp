@@ -0,0 +1,112 @@
+/*
+ * Нагрузочный тест StrategySlot: READERS потоков без остановки вызывают
+ * performFly() и fight(), а управляющий поток SWAPS раз меняет стратегии
+ * через setFlyBehavior() и setWeapon().
+ *
+ * Каждое поведение хранит метку, которую деструктор стирает. Если поток
+ * вызовет уже удаленное поведение, тест увидит стертую метку (а TSAN или
+ * ASAN сообщат о гонке или use-after-free раньше).
+ *
+ *   ./strategy_slot_stress [swaps] [readers]
+ */
+#include "Character.h"
+#include "Duck.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+constexpr std::uint64_t ALIVE = 0xA11FE5A11FE5ULL;
+
+std::atomic<std::uint64_t> calls { 0 };
+std::atomic<std::uint64_t> corrupted { 0 };
+
+// Метка стирается в деструкторе, вызов удаленного поведения ее увидит
+class Canary {
+private:
+    std::atomic<std::uint64_t> _mark { ALIVE };
+
+public:
+    ~Canary() { _mark.store(0, std::memory_order_relaxed); }
+
+    void check() const
+    {
+        if (_mark.load(std::memory_order_relaxed) != ALIVE) {
+            corrupted.fetch_add(1, std::memory_order_relaxed);
+        }
+        calls.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+// Поведения ничего не печатают, чтобы тест упирался в замену, а не в вывод
+class CheckedFly : public FlyBehavior {
+private:
+    Canary _canary;
+
+public:
+    void fly(std::ostream&) const override { _canary.check(); }
+};
+
+class CheckedQuack : public QuackBehavior {
+private:
+    Canary _canary;
+
+public:
+    void quack(std::ostream&) const override { _canary.check(); }
+};
+
+class CheckedWeapon : public WeaponType {
+private:
+    Canary _canary;
+
+public:
+    void useWeapon() const override { _canary.check(); }
+};
+
+int main(int argc, char* argv[])
+{
+    const long swaps = argc > 1 ? std::atol(argv[1]) : 200'000;
+    const unsigned readers = argc > 2
+        ? static_cast<unsigned>(std::atoi(argv[2]))
+        : std::max(4u, std::thread::hardware_concurrency());
+
+    Duck duck(std::make_unique<CheckedQuack>(), std::make_unique<CheckedFly>());
+    Character character(std::make_unique<CheckedWeapon>());
+    std::ostream discard(nullptr);
+
+    std::atomic<bool> done { false };
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < readers; ++i) {
+        workers.emplace_back([&] {
+            for (unsigned iteration = 1; !done.load(std::memory_order_relaxed); ++iteration) {
+                duck.performFly(discard);
+                duck.performQuack(discard);
+                character.fight();
+                // На машине с малым числом ядер писатель иначе почти
+                // не получит CPU
+                if (iteration % 64 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // setWeapon() печатает каждую замену, поэтому оружие меняем через слот
+    for (long i = 0; i < swaps; ++i) {
+        duck.setFlyBehavior(std::make_unique<CheckedFly>());
+        duck.setQuackBehavior(std::make_unique<CheckedQuack>());
+        character.weaponType.store(std::make_unique<CheckedWeapon>());
+    }
+    done.store(true, std::memory_order_relaxed);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::cout << readers << " readers, " << swaps << " swaps per slot, " << calls.load()
+              << " calls, " << corrupted.load() << " calls into a deleted strategy"
+              << std::endl;
+    return corrupted.load() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,152 @@
+/*
+ * Владеющий указатель на стратегию с небольшим встроенным буфером.
+ *
+ * std::unique_ptr<FlyBehavior> требует выделения в куче на каждое
+ * поведение, хотя все поведения из FlyBehavior.h, QuackBehavior.h и
+ * Weapon.h занимают один указатель на vtable. InlineStrategy<Interface, N>
+ * хранит объект прямо в себе, если он помещается в N байт, и уходит в кучу
+ * только для больших поведений:
+ *
+ *   InlineStrategy<FlyBehavior>
+ *   +-----------+-------+---------------------------+
+ *   | _object --|-+     | _buffer[N]                |
+ *   | _relocate |  \--->| FlyWithWings (vptr)       |   маленькое поведение
+ *   +-----------+-------+---------------------------+
+ *
+ *   +-----------+-------+---------------------------+
+ *   | _object --|--+    | не используется           |   большое поведение
+ *   +-----------+--|----+---------------------------+
+ *                  +--> куча: BigPluginBehavior
+ *
+ * В отличие от std::variant набор поведений не закрыт: подойдет любой
+ * наследник Interface, в том числе из плагинов. Как и unique_ptr, объект
+ * только перемещается и принимает std::unique_ptr, поэтому может заменить
+ * член класса без правки вызывающего кода.
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Interface, std::size_t Capacity = 2 * sizeof(void*)>
+class InlineStrategy {
+    static_assert(std::has_virtual_destructor_v<Interface>,
+        "Strategy interface must have a virtual destructor");
+
+private:
+    // Перемещает объект из одного буфера в другой и разрушает исходный.
+    // Для объекта в куче не нужна: переносится только указатель.
+    using Relocate = Interface* (*)(void* from, void* to) noexcept;
+
+    alignas(std::max_align_t) unsigned char _buffer[Capacity];
+    Interface* _object = nullptr;
+    Relocate _relocate = nullptr;
+
+    template <typename Derived>
+    static constexpr bool fitsInline = sizeof(Derived) <= Capacity
+        && alignof(Derived) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible_v<Derived>;
+
+    template <typename Derived>
+    static Interface* relocate(void* from, void* to) noexcept
+    {
+        auto* source = static_cast<Derived*>(from);
+        Interface* moved = ::new (to) Derived(std::move(*source));
+        source->~Derived();
+        return moved;
+    }
+
+    void reset() noexcept
+    {
+        if (!_object) {
+            return;
+        }
+        if (_relocate) {
+            // Деструктор виртуальный, память буфера освобождать не нужно
+            _object->~Interface();
+        } else {
+            delete _object;
+        }
+        _object = nullptr;
+        _relocate = nullptr;
+    }
+
+    void moveFrom(InlineStrategy& other) noexcept
+    {
+        if (other._relocate) {
+            // Derived лежит в начале буфера, а Interface может быть смещен
+            _object = other._relocate(other._buffer, _buffer);
+        } else {
+            _object = other._object;
+        }
+        _relocate = other._relocate;
+        other._object = nullptr;
+        other._relocate = nullptr;
+    }
+
+    template <typename Derived, typename... Args>
+    void emplace(Args&&... args)
+    {
+        if constexpr (fitsInline<Derived>) {
+            _object = ::new (static_cast<void*>(_buffer)) Derived(std::forward<Args>(args)...);
+            _relocate = &relocate<Derived>;
+        } else {
+            _object = new Derived(std::forward<Args>(args)...);
+        }
+    }
+
+public:
+    InlineStrategy() noexcept = default;
+
+    // Из готового объекта поведения: InlineStrategy<FlyBehavior>(FlyWithWings())
+    template <typename Derived>
+        requires std::is_base_of_v<Interface, std::remove_cvref_t<Derived>>
+    InlineStrategy(Derived&& behavior)
+    {
+        emplace<std::remove_cvref_t<Derived>>(std::forward<Derived>(behavior));
+    }
+
+    // Совместимость с unique_ptr: объект уже в куче, просто забираем его
+    template <typename Derived>
+        requires std::is_base_of_v<Interface, Derived>
+    InlineStrategy(std::unique_ptr<Derived> behavior) noexcept
+        : _object(behavior.release())
+    {
+    }
+
+    // Аналог std::make_unique: InlineStrategy<FlyBehavior>::make<FlyWithWings>()
+    template <typename Derived, typename... Args>
+    static InlineStrategy make(Args&&... args)
+    {
+        InlineStrategy strategy;
+        strategy.emplace<Derived>(std::forward<Args>(args)...);
+        return strategy;
+    }
+
+    InlineStrategy(InlineStrategy&& other) noexcept { moveFrom(other); }
+
+    InlineStrategy& operator=(InlineStrategy&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    InlineStrategy(const InlineStrategy&) = delete;
+    InlineStrategy& operator=(const InlineStrategy&) = delete;
+
+    ~InlineStrategy() { reset(); }
+
+    Interface* get() const noexcept { return _object; }
+    Interface* operator->() const noexcept { return _object; }
+    Interface& operator*() const noexcept { return *_object; }
+    explicit operator bool() const noexcept { return _object != nullptr; }
+
+    // Объект лежит во встроенном буфере, а не в куче
+    bool isInline() const noexcept { return _relocate != nullptr; }
+};
@@ -0,0 +1,261 @@
+/*
+ * Потокобезопасный слот для стратегии с заменой "на лету".
+ *
+ * Обычный std::unique_ptr<Behavior> нельзя менять, пока другой поток
+ * вызывает через него метод: старое поведение будет удалено посреди вызова.
+ * StrategySlot хранит атомарный указатель:
+ *
+ *   - читатель (performFly(), fight() и т.д.) никогда не блокируется:
+ *     он отмечает свой поток в текущей эпохе и читает указатель;
+ *   - замена это один атомарный exchange, старое поведение не удаляется
+ *     сразу, а откладывается (retire);
+ *   - отложенный объект удаляется, только когда все потоки, которые могли
+ *     его видеть, вышли из своих вызовов (epoch based reclamation).
+ *
+ *   Эпоха:        e            e+1            e+2
+ *   Читатель 1: [pin e ... unpin]
+ *   Писатель:       exchange -> retire(old, e)
+ *   Читатель 2:                 [pin e+1 ... unpin]
+ *                                              ^ old можно удалить
+ *
+ * Глобальная эпоха сдвигается, только когда все активные потоки уже
+ * в ней. Объект, отложенный в эпохе e, удаляется при эпохе e+2: к этому
+ * моменту ни один поток не может держать на него указатель.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace epoch {
+
+class Domain {
+private:
+    static constexpr std::uint64_t IDLE = ~std::uint64_t(0);
+
+    // Запись потока. Записи не удаляются, после завершения потока
+    // их переиспользуют новые потоки.
+    struct alignas(64) Record {
+        std::atomic<std::uint64_t> epoch { IDLE };
+        std::atomic<bool> used { true };
+        Record* next = nullptr;
+    };
+
+    struct Retired {
+        void* pointer;
+        void (*deleter)(void*);
+        std::uint64_t epoch;
+        Retired* next;
+    };
+
+    alignas(64) std::atomic<std::uint64_t> _global { 0 };
+    std::atomic<Record*> _records { nullptr };
+    // Стек отложенных объектов, в него пишут без блокировок
+    std::atomic<Retired*> _retired { nullptr };
+    // Удалением занимается только один поток за раз, остальные не ждут
+    std::mutex _reclaimMutex;
+    std::vector<Retired*> _limbo;
+
+    Record* acquireRecord()
+    {
+        for (Record* record = _records.load(std::memory_order_acquire); record;
+             record = record->next) {
+            bool used = false;
+            if (!record->used.load(std::memory_order_relaxed)
+                && record->used.compare_exchange_strong(used, true)) {
+                return record;
+            }
+        }
+        auto* record = new Record();
+        record->next = _records.load(std::memory_order_relaxed);
+        while (!_records.compare_exchange_weak(record->next, record,
+            std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        return record;
+    }
+
+    // Запись текущего потока, возвращается в домен при завершении потока
+    struct ThreadState {
+        Record* record = nullptr;
+        unsigned nesting = 0;
+
+        ~ThreadState()
+        {
+            if (record) {
+                record->epoch.store(IDLE, std::memory_order_release);
+                record->used.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    Record* threadRecord()
+    {
+        ThreadState& state = threadState();
+        if (!state.record) {
+            state.record = acquireRecord();
+        }
+        return state.record;
+    }
+
+    static ThreadState& threadState()
+    {
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    // Сдвигаем эпоху, если все активные потоки уже в текущей
+    std::uint64_t tryAdvance()
+    {
+        std::uint64_t current = _global.load(std::memory_order_seq_cst);
+        for (Record* record = _records.load(std::memory_order_acquire); record;
+             record = record->next) {
+            std::uint64_t epoch = record->epoch.load(std::memory_order_seq_cst);
+            if (epoch != IDLE && epoch != current) {
+                return current;
+            }
+        }
+        _global.compare_exchange_strong(current, current + 1, std::memory_order_seq_cst);
+        return _global.load(std::memory_order_seq_cst);
+    }
+
+public:
+    static Domain& instance()
+    {
+        static Domain domain;
+        return domain;
+    }
+
+    ~Domain()
+    {
+        // К моменту разрушения статического домена читателей уже нет
+        reclaim(true);
+        for (Record* record = _records.load(); record;) {
+            Record* next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+
+    // Вход в критическую секцию читателя. Вложенные входы просто считаются.
+    void pin()
+    {
+        ThreadState& state = threadState();
+        Record* record = threadRecord();
+        if (state.nesting++ == 0) {
+            // seq_cst: объявление эпохи должно стать видно до чтения указателя
+            record->epoch.store(_global.load(std::memory_order_seq_cst),
+                std::memory_order_seq_cst);
+        }
+    }
+
+    void unpin()
+    {
+        ThreadState& state = threadState();
+        if (--state.nesting == 0) {
+            state.record->epoch.store(IDLE, std::memory_order_release);
+        }
+    }
+
+    // Откладываем удаление объекта, который уже недоступен новым читателям
+    template <typename T>
+    void retire(T* pointer)
+    {
+        auto* retired = new Retired { pointer,
+            [](void* p) { delete static_cast<T*>(p); },
+            _global.load(std::memory_order_seq_cst),
+            _retired.load(std::memory_order_relaxed) };
+        while (!_retired.compare_exchange_weak(retired->next, retired,
+            std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        reclaim(false);
+    }
+
+    // Удаляем все, что пережило две эпохи. Если удалением уже занят другой
+    // поток, просто выходим: ничего не ждем.
+    void reclaim(bool everything)
+    {
+        std::unique_lock<std::mutex> lock(_reclaimMutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;
+        }
+        for (Retired* retired = _retired.exchange(nullptr, std::memory_order_acquire);
+             retired;) {
+            Retired* next = retired->next;
+            _limbo.push_back(retired);
+            retired = next;
+        }
+        // Если читателей сейчас нет, за два шага освобождаем и только что
+        // отложенный объект
+        tryAdvance();
+        std::uint64_t global = tryAdvance();
+        std::erase_if(_limbo, [&](Retired* retired) {
+            if (!everything && retired->epoch + 2 > global) {
+                return false;
+            }
+            retired->deleter(retired->pointer);
+            delete retired;
+            return true;
+        });
+    }
+};
+
+// RAII обертка над pin()/unpin()
+class Guard {
+public:
+    Guard() { Domain::instance().pin(); }
+    ~Guard() { Domain::instance().unpin(); }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+};
+
+} // namespace epoch
+
+template <typename T>
+class StrategySlot {
+private:
+    std::atomic<T*> _pointer;
+
+public:
+    // Ссылка на текущую стратегию. Пока она жива, стратегия не будет удалена,
+    // даже если другой поток ее заменит.
+    class Ref {
+    private:
+        epoch::Guard _guard;
+        T* _pointer;
+
+    public:
+        explicit Ref(const std::atomic<T*>& pointer)
+            : _pointer(pointer.load(std::memory_order_seq_cst))
+        {
+        }
+
+        T* operator->() const { return _pointer; }
+        T& operator*() const { return *_pointer; }
+    };
+
+    explicit StrategySlot(std::unique_ptr<T> strategy)
+        : _pointer(strategy.release())
+    {
+    }
+
+    // Владелец удаляет слот, когда вызовов через него уже нет
+    ~StrategySlot() { delete _pointer.load(std::memory_order_acquire); }
+
+    StrategySlot(const StrategySlot&) = delete;
+    StrategySlot& operator=(const StrategySlot&) = delete;
+
+    Ref load() const { return Ref(_pointer); }
+
+    // Замена без блокировок: старую стратегию удалит домен эпох
+    void store(std::unique_ptr<T> strategy)
+    {
+        T* old = _pointer.exchange(strategy.release(), std::memory_order_acq_rel);
+        if (old) {
+            epoch::Domain::instance().retire(old);
+        }
+    }
+};
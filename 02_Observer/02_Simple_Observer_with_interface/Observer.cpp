@@ -12,6 +12,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
 // Объявляем базовый класс который будет выступать в роли интерфейса
 class BaseObserver {
@@ -74,17 +75,24 @@ public:
 };
 
 class Subject : public BaseSubject {
-public:
-    // Добавляем экземпляр наблюдателя в список
-    virtual void addObserver(std::shared_ptr<Observer> observer)
+private:
+    // Изменение подписки, отложенное до конца рассылки
+    struct PendingChange {
+        bool add;
+        std::shared_ptr<Observer> observer;
+    };
+    std::vector<PendingChange> _pending;
+    // Глубина вложенных вызовов notify
+    int _dispatchDepth = 0;
+
+    void applyAdd(std::shared_ptr<Observer> observer)
     {
         _observers.push_front(observer);
         std::cout << observer.get()->getName() << " added to subscription."
                   << std::endl;
     }
 
-    // Удаляем экземпляр наблюдателя из списка
-    virtual void removeObserver(std::shared_ptr<Observer>& observer)
+    void applyRemove(std::shared_ptr<Observer>& observer)
     {
         _observers.remove(observer);
         // Обнуляем счетчик ссылок наблюдателя для удаления его из памяти
@@ -93,9 +101,77 @@ public:
         observer.reset();
     }
 
-    // В цикле перебираем список наблюдателей и вызываем у них метод notify
+    // Применяем все накопленные изменения одной пачкой
+    void applyPending()
+    {
+        std::vector<PendingChange> pending;
+        pending.swap(_pending);
+        for (auto& change : pending) {
+            if (change.add) {
+                applyAdd(change.observer);
+            } else {
+                applyRemove(change.observer);
+            }
+        }
+    }
+
+    // Отмечает рассылку на время notify(). Деструктор срабатывает и при
+    // исключении из наблюдателя, поэтому глубина не "застревает" и
+    // отложенные изменения все равно применяются.
+    class DispatchGuard {
+    private:
+        Subject& _subject;
+
+    public:
+        explicit DispatchGuard(Subject& subject)
+            : _subject(subject)
+        {
+            ++_subject._dispatchDepth;
+        }
+
+        ~DispatchGuard()
+        {
+            if (--_subject._dispatchDepth == 0 && !_subject._pending.empty()) {
+                _subject.applyPending();
+            }
+        }
+
+        DispatchGuard(const DispatchGuard&) = delete;
+        DispatchGuard& operator=(const DispatchGuard&) = delete;
+    };
+
+public:
+    // Добавляем экземпляр наблюдателя в список.
+    // Если вызвано из notify() наблюдателя, список сейчас обходится,
+    // поэтому изменение откладывается до конца рассылки.
+    virtual void addObserver(std::shared_ptr<Observer> observer)
+    {
+        if (_dispatchDepth > 0) {
+            _pending.push_back({ true, observer });
+            return;
+        }
+        applyAdd(observer);
+    }
+
+    // Удаляем экземпляр наблюдателя из списка
+    virtual void removeObserver(std::shared_ptr<Observer>& observer)
+    {
+        if (_dispatchDepth > 0) {
+            // Список держит свою копию указателя до конца рассылки,
+            // поэтому наблюдатель не будет удален посреди обхода
+            _pending.push_back({ false, observer });
+            observer.reset();
+            return;
+        }
+        applyRemove(observer);
+    }
+
+    // В цикле перебираем список наблюдателей и вызываем у них метод notify.
+    // Список не копируется: изменения во время обхода откладываются и
+    // применяются после выхода из самого внешнего notify().
     void notify()
     {
+        DispatchGuard guard(*this);
         for (auto& observer : _observers) {
             observer->notify();
         }
@@ -35,6 +35,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 // Объявляем базовый класс который будет выступать в роли интерфейса
 class BaseObserver {
@@ -116,9 +117,32 @@ public:
         LOG,
         ALL };
 
-    // Добавляем экземпляр наблюдателя в список
-    void addObserver(int messageTypes,
-        std::shared_ptr<Observer> observer) override
+private:
+    // Изменение подписки, отложенное до конца рассылки
+    struct PendingChange {
+        bool add;
+        int messageTypes;
+        std::shared_ptr<Observer> observer;
+    };
+    std::vector<PendingChange> _pending;
+    // Глубина вложенных вызовов notify
+    int _dispatchDepth = 0;
+
+    // Применяем все накопленные изменения одной пачкой
+    void applyPending()
+    {
+        std::vector<PendingChange> pending;
+        pending.swap(_pending);
+        for (auto& change : pending) {
+            if (change.add) {
+                applyAdd(change.messageTypes, change.observer);
+            } else {
+                applyRemove(change.messageTypes, change.observer);
+            }
+        }
+    }
+
+    void applyAdd(int messageTypes, std::shared_ptr<Observer> observer)
     {
         // Ищем тип сообщения в списке, т.е. его номер ENUM
         auto it = _observers.find(messageTypes);
@@ -136,9 +160,7 @@ public:
                   << std::endl;
     }
 
-    // Удаляем экземпляр наблюдателя из списка
-    void removeObserver(int messageTypes,
-        std::shared_ptr<Observer>& observer) override
+    void applyRemove(int messageTypes, std::shared_ptr<Observer>& observer)
     {
         // Ищем топик по ключу map
         auto it = _observers.find(messageTypes);
@@ -180,14 +202,75 @@ public:
         }
     }
 
-    // В цикле перебираем список наблюдателей и вызываем у них метод notify
+    // Отмечает рассылку на время notify(). Деструктор срабатывает и при
+    // исключении из наблюдателя, поэтому глубина не "застревает" и
+    // отложенные изменения все равно применяются.
+    class DispatchGuard {
+    private:
+        Subject& _subject;
+
+    public:
+        explicit DispatchGuard(Subject& subject)
+            : _subject(subject)
+        {
+            ++_subject._dispatchDepth;
+        }
+
+        ~DispatchGuard()
+        {
+            if (--_subject._dispatchDepth == 0 && !_subject._pending.empty()) {
+                _subject.applyPending();
+            }
+        }
+
+        DispatchGuard(const DispatchGuard&) = delete;
+        DispatchGuard& operator=(const DispatchGuard&) = delete;
+    };
+
+public:
+    // Добавляем экземпляр наблюдателя в список.
+    // Если вызвано из notify() наблюдателя, списки сейчас обходятся,
+    // поэтому изменение откладывается до конца рассылки.
+    void addObserver(int messageTypes,
+        std::shared_ptr<Observer> observer) override
+    {
+        if (_dispatchDepth > 0) {
+            std::cout << observer->getName() << " subscription on event #"
+                      << messageTypes << " deferred" << std::endl;
+            _pending.push_back({ true, messageTypes, observer });
+            return;
+        }
+        applyAdd(messageTypes, observer);
+    }
+
+    // Удаляем экземпляр наблюдателя из списка
+    void removeObserver(int messageTypes,
+        std::shared_ptr<Observer>& observer) override
+    {
+        if (_dispatchDepth > 0) {
+            // Список держит свою копию указателя до конца рассылки,
+            // поэтому наблюдатель не будет удален посреди обхода
+            std::cout << observer->getName() << " removal from event #"
+                      << messageTypes << " deferred" << std::endl;
+            _pending.push_back({ false, messageTypes, observer });
+            observer.reset();
+            return;
+        }
+        applyRemove(messageTypes, observer);
+    }
+
+    // В цикле перебираем список наблюдателей и вызываем у них метод notify.
+    // Списки не копируются: изменения во время обхода (в том числе из
+    // вложенных notify) откладываются и применяются после выхода из самого
+    // внешнего notify().
     void notify(int event) override
     {
+        DispatchGuard guard(*this);
         for (auto& mObserver : _observers) {
             // Если сообщения направлены всем или определенным наблюдателям
             if (event == ALL || event == mObserver.first) {
                 // Перебираем forward_list
-                for (auto fObserver : mObserver.second) {
+                for (auto& fObserver : mObserver.second) {
                     fObserver->notify();
                 }
             }
@@ -195,6 +278,37 @@ public:
     }
 };
 
+// Наблюдатель, который сам меняет подписки из своего notify():
+// подписывает новичка на LOG, отписывается сам и вызывает вложенный notify
+class Recruiter : public Observer {
+private:
+    Subject& _subject;
+    std::shared_ptr<Observer> _recruit;
+    std::shared_ptr<Observer> _self;
+
+public:
+    Recruiter(const std::string& name, Subject& subject,
+        std::shared_ptr<Observer> recruit)
+        : Observer(name)
+        , _subject(subject)
+        , _recruit(std::move(recruit))
+    {
+    }
+
+    void setSelf(std::shared_ptr<Observer> self) { _self = std::move(self); }
+
+    void notify() override
+    {
+        Observer::notify();
+        if (_recruit) {
+            _subject.addObserver(Subject::LOG, _recruit);
+            _recruit.reset();
+            _subject.notify(Subject::LOG);
+            _subject.removeObserver(Subject::DATA, _self);
+        }
+    }
+};
+
 int main()
 {
     // Создаем 4 экземпляра наблюдателя
@@ -239,5 +353,16 @@ int main()
     subject.notify(Subject::MQTT);
     std::cout << std::endl;
 
+    // Изменения подписки изнутри notify() откладываются до конца рассылки
+    auto recruiter = std::make_shared<Recruiter>("Recruiter", subject,
+        Observer::make("Observer9"));
+    recruiter->setSelf(recruiter);
+    subject.addObserver(Subject::DATA, recruiter);
+    std::cout << std::endl;
+    subject.notify(Subject::DATA);
+    std::cout << std::endl;
+    subject.notify(Subject::ALL);
+    std::cout << std::endl;
+
     return 0;
 }
@@ -0,0 +1,753 @@
+/*
+ * Паттерн наблюдатель между процессами через разделяемую память.
+ *
+ * Субъект живет в одном процессе, а наблюдатели в другом процессе на той же
+ * машине. Вместо сокета и сериализации каждого сообщения используем
+ * кольцевой буфер в разделяемой памяти (shm_open + mmap):
+ *
+ *   - издатель (один процесс) пишет сообщение прямо в слот кольца;
+ *   - подписчик читает сообщение прямо из слота, без копирования
+ *     (наблюдатель получает std::string_view на память кольца);
+ *   - ожидание новых сообщений и свободного места сделано на futex, причем
+ *     системный вызов FUTEX_WAKE делается только если кто-то реально спит;
+ *   - если процесс упал, его следы убираются: издатель пересоздает
+ *     "осиротевший" сегмент, а курсор умершего подписчика освобождается
+ *     и больше не держит кольцо.
+ *
+ *   Процесс издателя                     Процесс подписчика
+ *   +---------+   notify(LOG)            +---------------+
+ *   | Subject |-----------+              | RemoteSubject |
+ *   +---------+           v              +-------^-------+
+ *               +--------------------+           | string_view
+ *               |SharedMemoryObserver|           |
+ *               +---------|----------+           |
+ *                         v                      |
+ *   +--------------------------------------------------------------+
+ *   | Header | Consumers[] | Slot 0 | Slot 1 | ... | Slot N-1       |
+ *   +--------------------------------------------------------------+
+ *
+ * Издатель не перезаписывает слот, пока его не прочитали все живые
+ * подписчики, поэтому чтение без копирования безопасно.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <forward_list>
+#include <fstream>
+#include <iostream>
+#include <linux/futex.h>
+#include <map>
+#include <stdexcept>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+// Объявляем базовый класс который будет выступать в роли интерфейса
+class BaseObserver {
+public:
+    // Обязательно при объявлении виртуальной функции
+    // создаем виртуальный деструктор
+    virtual ~BaseObserver() { }
+
+    virtual void notify() = 0;
+    virtual std::string getName() = 0;
+};
+
+class Observer : public BaseObserver {
+private:
+    std::string _name;
+
+public:
+    Observer(const std::string& name)
+        : _name(name)
+    {
+    }
+
+    void notify() override
+    {
+        std::cout << "Hello! I'm a " + getName() << std::endl;
+    }
+
+    std::string getName() override { return _name; }
+
+    static std::shared_ptr<Observer> make(std::string name)
+    {
+        return std::make_shared<Observer>(name);
+    }
+};
+
+// Субъект из предыдущего примера, только хранит интерфейс BaseObserver,
+// чтобы в список можно было положить мост в разделяемую память.
+class Subject {
+public:
+    enum MessageTypes { DATA,
+        MQTT,
+        LOG,
+        ALL };
+
+private:
+    typedef std::forward_list<std::shared_ptr<BaseObserver>> ObserversList;
+    typedef std::map<int, ObserversList> ObserversMap;
+
+    ObserversMap _observers;
+
+public:
+    void addObserver(int messageTypes, std::shared_ptr<BaseObserver> observer)
+    {
+        _observers[messageTypes].push_front(observer);
+        std::cout << observer->getName() << " added to subscription on event #"
+                  << messageTypes << std::endl;
+    }
+
+    void notify(int event)
+    {
+        for (auto& mObserver : _observers) {
+            if (event == ALL || event == mObserver.first) {
+                for (auto& fObserver : mObserver.second) {
+                    fObserver->notify();
+                }
+            }
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Раскладка разделяемой памяти.
+// Все поля, которые меняются конкурентно, это std::atomic без блокировок,
+// такие атомики работают и между процессами.
+// ---------------------------------------------------------------------------
+namespace shm {
+
+constexpr std::uint32_t MAGIC = 0x4f425352; // "OBSR"
+constexpr std::uint32_t VERSION = 1;
+constexpr std::size_t SLOT_COUNT = 1024; // Степень двойки
+constexpr std::size_t PAYLOAD_SIZE = 240;
+constexpr std::size_t MAX_CONSUMERS = 16;
+// Сколько ждем на futex перед проверкой что другая сторона еще жива
+constexpr auto LIVENESS_PERIOD = std::chrono::milliseconds(100);
+// Сколько подписчик ждет, пока издатель создаст и разметит сегмент
+constexpr auto ATTACH_TIMEOUT = std::chrono::seconds(5);
+
+static_assert((SLOT_COUNT & (SLOT_COUNT - 1)) == 0);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+
+// Курсор одного подписчика. pid == 0 значит что место свободно.
+struct alignas(64) Consumer {
+    std::atomic<pid_t> pid;
+    // Номер следующего сообщения, которое подписчик еще не прочитал
+    std::atomic<std::uint64_t> readSeq;
+};
+
+struct alignas(64) Header {
+    std::uint32_t magic;
+    std::uint32_t version;
+    pid_t ownerPid;
+    std::atomic<std::uint32_t> closed;
+
+    // Номер следующего сообщения которое запишет издатель
+    alignas(64) std::atomic<std::uint64_t> writeSeq;
+    // Слово futex для подписчиков, увеличивается на каждую публикацию
+    std::atomic<std::uint32_t> dataFutex;
+    // Количество подписчиков, спящих на dataFutex
+    std::atomic<std::uint32_t> dataWaiters;
+
+    // Слово futex для издателя, когда кольцо заполнено
+    alignas(64) std::atomic<std::uint32_t> spaceFutex;
+    std::atomic<std::uint32_t> spaceWaiters;
+
+    Consumer consumers[MAX_CONSUMERS];
+};
+
+struct alignas(64) Slot {
+    std::uint32_t topic;
+    std::uint32_t size;
+    char payload[PAYLOAD_SIZE];
+};
+
+struct Segment {
+    Header header;
+    Slot slots[SLOT_COUNT];
+};
+
+// Обертки над системным вызовом futex. Флаг FUTEX_PRIVATE не ставим,
+// т.к. слово лежит в памяти, общей для разных процессов.
+inline void futexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected)
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(LIVENESS_PERIOD);
+    timespec timeout { 0, static_cast<long>(ns.count()) };
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT,
+        expected, &timeout, nullptr, 0);
+}
+
+inline void futexWakeAll(std::atomic<std::uint32_t>& word)
+{
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE,
+        INT32_MAX, nullptr, nullptr, 0);
+}
+
+// Проверяем что процесс с таким pid еще существует.
+// kill(pid, 0) успешен и для зомби: упавший дочерний процесс, которого
+// родитель еще не забрал через waitpid, остается в таблице процессов.
+// Поэтому дополнительно смотрим состояние в /proc/<pid>/stat.
+inline bool isAlive(pid_t pid)
+{
+    if (pid <= 0 || (kill(pid, 0) != 0 && errno != EPERM)) {
+        return false;
+    }
+    std::ifstream procStat("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    if (!std::getline(procStat, line)) {
+        // /proc недоступен, остается только ответ kill
+        return true;
+    }
+    // Формат: "pid (comm) S ...", comm может содержать скобки и пробелы
+    std::size_t comm = line.rfind(')');
+    if (comm == std::string::npos || comm + 2 >= line.size()) {
+        return true;
+    }
+    char state = line[comm + 2];
+    return state != 'Z' && state != 'X';
+}
+
+inline std::string segmentName(const std::string& name) { return "/observer_" + name; }
+
+inline Segment* mapSegment(int fd)
+{
+    void* addr = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "mmap");
+    }
+    return static_cast<Segment*>(addr);
+}
+
+} // namespace shm
+
+// ---------------------------------------------------------------------------
+// Сторона издателя. Владеет сегментом и удаляет его в деструкторе.
+// ---------------------------------------------------------------------------
+class SharedMemoryPublisher {
+private:
+    std::string _name;
+    shm::Segment* _segment = nullptr;
+    // Последний вычисленный курсор самого отстающего подписчика.
+    // Курсоры только растут, поэтому пересчитываем его, только когда
+    // кольцо по этой оценке заполнено.
+    std::uint64_t _minReadSeq = 0;
+
+    // Самый отстающий подписчик
+    std::uint64_t minReadSeq(std::uint64_t writeSeq)
+    {
+        std::uint64_t minSeq = writeSeq;
+        for (auto& consumer : _segment->header.consumers) {
+            pid_t pid = consumer.pid.load(std::memory_order_acquire);
+            if (pid == 0) {
+                continue;
+            }
+            // seq_cst: повторная проверка после spaceWaiters.fetch_add
+            std::uint64_t seq = consumer.readSeq.load(std::memory_order_seq_cst);
+            if (seq < minSeq) {
+                minSeq = seq;
+            }
+        }
+        return minSeq;
+    }
+
+    void releaseDeadConsumers()
+    {
+        for (auto& consumer : _segment->header.consumers) {
+            pid_t pid = consumer.pid.load(std::memory_order_acquire);
+            if (pid != 0 && !shm::isAlive(pid)) {
+                std::cout << "Consumer " << pid << " died, releasing its cursor"
+                          << std::endl;
+                consumer.pid.compare_exchange_strong(pid, 0);
+            }
+        }
+    }
+
+public:
+    SharedMemoryPublisher(const std::string& name)
+        : _name(shm::segmentName(name))
+    {
+        int fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            // Сегмент остался от упавшего издателя? Проверяем владельца.
+            int old = shm_open(_name.c_str(), O_RDWR, 0600);
+            if (old >= 0) {
+                struct stat st { };
+                bool stale = true;
+                if (fstat(old, &st) == 0 && st.st_size == sizeof(shm::Segment)) {
+                    shm::Segment* segment = shm::mapSegment(old);
+                    stale = !shm::isAlive(segment->header.ownerPid);
+                    munmap(segment, sizeof(shm::Segment));
+                }
+                close(old);
+                if (!stale) {
+                    throw std::runtime_error(_name + " is owned by a live publisher");
+                }
+            }
+            std::cout << "Removing stale segment " << _name << std::endl;
+            shm_unlink(_name.c_str());
+            fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        }
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open");
+        }
+        if (ftruncate(fd, sizeof(shm::Segment)) != 0) {
+            int error = errno;
+            close(fd);
+            shm_unlink(_name.c_str());
+            throw std::system_error(error, std::generic_category(), "ftruncate");
+        }
+        _segment = shm::mapSegment(fd);
+        close(fd);
+
+        // ftruncate заполняет память нулями, атомики уже в начальном состоянии.
+        // magic пишем последним, подписчик ждет его перед подключением.
+        _segment->header.version = shm::VERSION;
+        _segment->header.ownerPid = getpid();
+        std::atomic_ref<std::uint32_t>(_segment->header.magic)
+            .store(shm::MAGIC, std::memory_order_release);
+    }
+
+    SharedMemoryPublisher(const SharedMemoryPublisher&) = delete;
+    SharedMemoryPublisher& operator=(const SharedMemoryPublisher&) = delete;
+
+    ~SharedMemoryPublisher()
+    {
+        // Сообщаем подписчикам о закрытии и будим их
+        _segment->header.closed.store(1, std::memory_order_release);
+        _segment->header.dataFutex.fetch_add(1, std::memory_order_release);
+        shm::futexWakeAll(_segment->header.dataFutex);
+        munmap(_segment, sizeof(shm::Segment));
+        // Имя удаляем сразу, память освободится когда ее отмапят все процессы
+        shm_unlink(_name.c_str());
+    }
+
+    // Ждем пока хотя бы один подписчик займет курсор: все что опубликовано
+    // раньше, никто не прочитает. false если за timeout никто не пришел.
+    bool waitForConsumer(std::chrono::milliseconds timeout)
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (;;) {
+            for (auto& consumer : _segment->header.consumers) {
+                if (consumer.pid.load(std::memory_order_acquire) != 0) {
+                    return true;
+                }
+            }
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Публикуем сообщение в топик. Если кольцо заполнено, ждем пока
+    // отстающий подписчик его прочитает (или умрет).
+    // Сообщение длиннее PAYLOAD_SIZE не помещается в слот и отклоняется.
+    void publish(int topic, std::string_view payload)
+    {
+        if (payload.size() > shm::PAYLOAD_SIZE) {
+            throw std::length_error("payload of " + std::to_string(payload.size())
+                + " bytes exceeds slot size " + std::to_string(shm::PAYLOAD_SIZE));
+        }
+
+        auto& header = _segment->header;
+        std::uint64_t seq = header.writeSeq.load(std::memory_order_relaxed);
+
+        if (seq - _minReadSeq >= shm::SLOT_COUNT) {
+            _minReadSeq = minReadSeq(seq);
+        }
+        while (seq - _minReadSeq >= shm::SLOT_COUNT) {
+            std::uint32_t space = header.spaceFutex.load(std::memory_order_acquire);
+            header.spaceWaiters.fetch_add(1, std::memory_order_seq_cst);
+            _minReadSeq = minReadSeq(seq);
+            if (seq - _minReadSeq >= shm::SLOT_COUNT) {
+                shm::futexWait(header.spaceFutex, space);
+            }
+            header.spaceWaiters.fetch_sub(1, std::memory_order_relaxed);
+            releaseDeadConsumers();
+            _minReadSeq = minReadSeq(seq);
+        }
+
+        shm::Slot& slot = _segment->slots[seq & (shm::SLOT_COUNT - 1)];
+        slot.topic = static_cast<std::uint32_t>(topic);
+        slot.size = static_cast<std::uint32_t>(payload.size());
+        std::memcpy(slot.payload, payload.data(), slot.size);
+
+        // Публикуем слот и будим подписчиков только если кто-то спит.
+        // Запись writeSeq и чтение dataWaiters должны быть seq_cst: release
+        // запись может переупорядочиться с последующим чтением, и тогда
+        // подписчик уснет, а мы не увидим его в dataWaiters.
+        header.writeSeq.store(seq + 1, std::memory_order_seq_cst);
+        header.dataFutex.fetch_add(1, std::memory_order_seq_cst);
+        if (header.dataWaiters.load(std::memory_order_seq_cst) != 0) {
+            shm::futexWakeAll(header.dataFutex);
+        }
+    }
+};
+
+// Мост: обычный наблюдатель, который пересылает уведомление своего топика
+// в разделяемую память. Подписывается на Subject как любой другой наблюдатель.
+class SharedMemoryObserver : public BaseObserver {
+private:
+    std::shared_ptr<SharedMemoryPublisher> _publisher;
+    int _topic;
+    std::string _name;
+
+public:
+    SharedMemoryObserver(std::shared_ptr<SharedMemoryPublisher> publisher,
+        int topic, const std::string& name)
+        : _publisher(std::move(publisher))
+        , _topic(topic)
+        , _name(name)
+    {
+    }
+
+    void notify() override { _publisher->publish(_topic, _name); }
+
+    std::string getName() override { return "SharedMemoryObserver(" + _name + ")"; }
+
+    static std::shared_ptr<SharedMemoryObserver> make(
+        std::shared_ptr<SharedMemoryPublisher> publisher, int topic,
+        const std::string& name)
+    {
+        return std::make_shared<SharedMemoryObserver>(std::move(publisher),
+            topic, name);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Сторона подписчика, живет в другом процессе.
+// ---------------------------------------------------------------------------
+
+// Наблюдатель в процессе подписчика получает полезную нагрузку прямо
+// из разделяемой памяти. string_view действителен только во время вызова.
+class BaseRemoteObserver {
+public:
+    virtual ~BaseRemoteObserver() { }
+
+    virtual void notify(int topic, std::string_view payload) = 0;
+};
+
+class RemoteObserver : public BaseRemoteObserver {
+private:
+    std::string _name;
+
+public:
+    RemoteObserver(const std::string& name)
+        : _name(name)
+    {
+    }
+
+    void notify(int topic, std::string_view payload) override
+    {
+        std::cout << "[pid " << getpid() << "] " << _name << " got event #"
+                  << topic << ": " << payload << std::endl;
+    }
+
+    static std::shared_ptr<RemoteObserver> make(std::string name)
+    {
+        return std::make_shared<RemoteObserver>(name);
+    }
+};
+
+class RemoteSubject {
+private:
+    typedef std::forward_list<std::shared_ptr<BaseRemoteObserver>> ObserversList;
+    typedef std::map<int, ObserversList> ObserversMap;
+
+    ObserversMap _observers;
+    shm::Segment* _segment = nullptr;
+    shm::Consumer* _consumer = nullptr;
+
+    // Занимаем свободное место курсора или место умершего процесса
+    shm::Consumer* claimConsumer()
+    {
+        pid_t self = getpid();
+        for (auto& consumer : _segment->header.consumers) {
+            pid_t pid = consumer.pid.load(std::memory_order_acquire);
+            if (pid != 0 && shm::isAlive(pid)) {
+                continue;
+            }
+            // Старый курсор не больше текущего writeSeq, поэтому пока мы
+            // его не сдвинули, издатель просто считает нас отстающими
+            if (consumer.pid.compare_exchange_strong(pid, self)) {
+                consumer.readSeq.store(
+                    _segment->header.writeSeq.load(std::memory_order_acquire),
+                    std::memory_order_release);
+                return &consumer;
+            }
+        }
+        throw std::runtime_error("no free consumer slots");
+    }
+
+    void dispatch(const shm::Slot& slot)
+    {
+        auto it = _observers.find(static_cast<int>(slot.topic));
+        if (it == _observers.end()) {
+            return;
+        }
+        std::string_view payload(slot.payload, slot.size);
+        for (auto& fObserver : it->second) {
+            fObserver->notify(static_cast<int>(slot.topic), payload);
+        }
+    }
+
+public:
+    RemoteSubject(const std::string& name)
+    {
+        std::string segmentName = shm::segmentName(name);
+        int fd = -1;
+        // Издатель мог еще не создать сегмент, немного подождем
+        for (int attempt = 0; attempt < 50 && fd < 0; ++attempt) {
+            fd = shm_open(segmentName.c_str(), O_RDWR, 0600);
+            if (fd < 0) {
+                std::this_thread::sleep_for(shm::LIVENESS_PERIOD / 10);
+            }
+        }
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open");
+        }
+
+        // Издатель, упавший между shm_open и записью magic, оставит сегмент
+        // недоделанным навсегда, поэтому оба ожидания ограничены по времени
+        auto deadline = std::chrono::steady_clock::now() + shm::ATTACH_TIMEOUT;
+        struct stat st { };
+        for (;;) {
+            if (fstat(fd, &st) != 0) {
+                int error = errno;
+                close(fd);
+                throw std::system_error(error, std::generic_category(), "fstat");
+            }
+            if (st.st_size >= static_cast<off_t>(sizeof(shm::Segment))) {
+                break;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) {
+                close(fd);
+                throw std::runtime_error(segmentName + " was never sized by its publisher");
+            }
+            std::this_thread::sleep_for(shm::LIVENESS_PERIOD / 10);
+        }
+        _segment = shm::mapSegment(fd);
+        close(fd);
+
+        std::atomic_ref<std::uint32_t> magic(_segment->header.magic);
+        while (magic.load(std::memory_order_acquire) != shm::MAGIC) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                munmap(_segment, sizeof(shm::Segment));
+                throw std::runtime_error(segmentName + " was never initialized by its publisher");
+            }
+            std::this_thread::sleep_for(shm::LIVENESS_PERIOD / 10);
+        }
+        if (_segment->header.version != shm::VERSION) {
+            munmap(_segment, sizeof(shm::Segment));
+            throw std::runtime_error(segmentName + " has unsupported version");
+        }
+        _consumer = claimConsumer();
+    }
+
+    RemoteSubject(const RemoteSubject&) = delete;
+    RemoteSubject& operator=(const RemoteSubject&) = delete;
+
+    ~RemoteSubject()
+    {
+        _consumer->pid.store(0, std::memory_order_release);
+        // Издатель мог ждать именно нас
+        _segment->header.spaceFutex.fetch_add(1, std::memory_order_seq_cst);
+        shm::futexWakeAll(_segment->header.spaceFutex);
+        munmap(_segment, sizeof(shm::Segment));
+    }
+
+    void addObserver(int messageTypes, std::shared_ptr<BaseRemoteObserver> observer)
+    {
+        if (messageTypes == Subject::ALL) {
+            for (int topic = Subject::DATA; topic < Subject::ALL; ++topic) {
+                _observers[topic].push_front(observer);
+            }
+        } else {
+            _observers[messageTypes].push_front(observer);
+        }
+    }
+
+    // Обрабатываем все доступные сообщения и ждем новые.
+    // Возвращает false, когда издатель закрылся или умер.
+    bool poll()
+    {
+        auto& header = _segment->header;
+        std::uint64_t readSeq = _consumer->readSeq.load(std::memory_order_relaxed);
+        std::uint64_t writeSeq = header.writeSeq.load(std::memory_order_acquire);
+
+        if (readSeq == writeSeq) {
+            if (header.closed.load(std::memory_order_acquire) != 0
+                || !shm::isAlive(header.ownerPid)) {
+                return false;
+            }
+            std::uint32_t data = header.dataFutex.load(std::memory_order_acquire);
+            header.dataWaiters.fetch_add(1, std::memory_order_seq_cst);
+            if (header.writeSeq.load(std::memory_order_seq_cst) == readSeq) {
+                shm::futexWait(header.dataFutex, data);
+            }
+            header.dataWaiters.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Читаем прямо из слотов, издатель не тронет их пока мы не сдвинем курсор
+        for (; readSeq != writeSeq; ++readSeq) {
+            dispatch(_segment->slots[readSeq & (shm::SLOT_COUNT - 1)]);
+        }
+        // seq_cst в паре с чтением spaceWaiters, как writeSeq в publish()
+        _consumer->readSeq.store(readSeq, std::memory_order_seq_cst);
+
+        if (header.spaceWaiters.load(std::memory_order_seq_cst) != 0) {
+            header.spaceFutex.fetch_add(1, std::memory_order_seq_cst);
+            shm::futexWakeAll(header.spaceFutex);
+        }
+        return true;
+    }
+};
+
+int main()
+{
+    const std::string channel = "demo_" + std::to_string(getpid());
+
+    pid_t child = fork();
+    if (child < 0) {
+        std::cerr << "fork failed" << std::endl;
+        return 1;
+    }
+
+    if (child == 0) {
+        // Процесс подписчика: слушаем DATA и LOG, MQTT нас не интересует
+        RemoteSubject remote(channel);
+        remote.addObserver(Subject::DATA, RemoteObserver::make("RemoteObserver1"));
+        remote.addObserver(Subject::LOG, RemoteObserver::make("RemoteObserver2"));
+        while (remote.poll()) {
+        }
+        std::cout << "[pid " << getpid() << "] publisher closed" << std::endl;
+        return 0;
+    }
+
+    {
+        // Процесс издателя
+        auto publisher = std::make_shared<SharedMemoryPublisher>(channel);
+
+        Subject subject;
+        subject.addObserver(Subject::LOG, Observer::make("Observer1"));
+        subject.addObserver(Subject::DATA,
+            SharedMemoryObserver::make(publisher, Subject::DATA, "data tick"));
+        subject.addObserver(Subject::MQTT,
+            SharedMemoryObserver::make(publisher, Subject::MQTT, "mqtt tick"));
+        subject.addObserver(Subject::LOG,
+            SharedMemoryObserver::make(publisher, Subject::LOG, "log line"));
+        std::cout << std::endl;
+
+        // Ждем подключения подписчика, иначе он начнет с текущего сообщения
+        if (!publisher->waitForConsumer(std::chrono::seconds(5))) {
+            std::cerr << "Subscriber did not attach" << std::endl;
+        }
+
+        subject.notify(Subject::ALL);
+        subject.notify(Subject::DATA);
+        subject.notify(Subject::MQTT);
+
+        try {
+            publisher->publish(Subject::LOG, std::string(shm::PAYLOAD_SIZE + 1, 'x'));
+        } catch (const std::length_error& error) {
+            std::cout << "Rejected: " << error.what() << std::endl;
+        }
+
+        // Подписчик падает посреди потока сообщений. Его курсор держит
+        // кольцо, пока издатель не заметит смерть процесса. Процесс
+        // остается зомби до waitpid ниже, издатель все равно должен
+        // освободить курсор и дописать все сообщения.
+        {
+            auto crashPublisher = std::make_shared<SharedMemoryPublisher>(channel + "_crash");
+            pid_t crashChild = fork();
+            if (crashChild == 0) {
+                RemoteSubject crash(channel + "_crash");
+                struct Crasher : BaseRemoteObserver {
+                    int count = 0;
+                    void notify(int, std::string_view) override
+                    {
+                        if (++count == 100) {
+                            raise(SIGKILL);
+                        }
+                    }
+                };
+                crash.addObserver(Subject::DATA, std::make_shared<Crasher>());
+                while (crash.poll()) {
+                }
+                _exit(0);
+            }
+            if (!crashPublisher->waitForConsumer(std::chrono::seconds(5))) {
+                std::cerr << "Crashing subscriber did not attach" << std::endl;
+            }
+            constexpr std::size_t CRASH_MESSAGES = 4 * shm::SLOT_COUNT;
+            for (std::size_t i = 0; i < CRASH_MESSAGES; ++i) {
+                crashPublisher->publish(Subject::DATA, "x");
+            }
+            std::cout << "Published " << CRASH_MESSAGES
+                      << " messages past a crashed subscriber" << std::endl;
+            int status = 0;
+            waitpid(crashChild, &status, 0);
+            if (WIFSIGNALED(status)) {
+                std::cout << "Subscriber " << crashChild << " was killed by signal "
+                          << WTERMSIG(status) << std::endl;
+            }
+        }
+
+        // Пропускная способность: много сообщений подряд, кольцо
+        // заполняется и издатель ждет подписчика на futex
+        auto benchPublisher = std::make_shared<SharedMemoryPublisher>(channel + "_bench");
+        pid_t benchChild = fork();
+        if (benchChild == 0) {
+            RemoteSubject bench(channel + "_bench");
+            struct Counter : BaseRemoteObserver {
+                std::uint64_t count = 0;
+                void notify(int, std::string_view) override { ++count; }
+            };
+            auto counter = std::make_shared<Counter>();
+            bench.addObserver(Subject::DATA, counter);
+            while (bench.poll()) {
+            }
+            std::cout << "[pid " << getpid() << "] received " << counter->count
+                      << " messages" << std::endl;
+            _exit(0);
+        }
+        if (!benchPublisher->waitForConsumer(std::chrono::seconds(5))) {
+            std::cerr << "Benchmark subscriber did not attach" << std::endl;
+        }
+
+        constexpr int MESSAGES = 1'000'000;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < MESSAGES; ++i) {
+            benchPublisher->publish(Subject::DATA, "x");
+        }
+        auto elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start);
+        std::cout << "Published " << MESSAGES << " messages in "
+                  << elapsed.count() << " s ("
+                  << static_cast<long>(MESSAGES / elapsed.count()) << " msg/s)"
+                  << std::endl;
+        benchPublisher.reset();
+        waitpid(benchChild, nullptr, 0);
+    }
+
+    waitpid(child, nullptr, 0);
+    return 0;
+}
@@ -0,0 +1,814 @@
+/*
+ * Паттерн наблюдатель с мостом в MQTT брокер.
+ *
+ * Топик MQTT в Subject::MessageTypes подразумевает пересылку уведомлений
+ * брокеру. Если на каждый notify() делать отдельную публикацию по сети,
+ * пропускная способность упирается в системные вызовы. Поэтому мост:
+ *
+ *   - в notify() только кладет сообщение в буфер и сразу возвращается;
+ *   - отдельный поток собирает пачку (batch) сообщений и отправляет ее
+ *     одной записью в сокет, пакеты PUBLISH идут подряд без ожидания
+ *     ответа (pipelining, QoS 0);
+ *   - пачка уходит когда набралось maxBatchMessages/maxBatchBytes или когда
+ *     самое старое сообщение прождало linger;
+ *   - при обрыве соединения переподключается с экспоненциальной задержкой,
+ *     а буфер ограничен maxBufferedMessages: самые старые сообщения
+ *     выбрасываются и учитываются в статистике.
+ *
+ *   +---------+ notify(MQTT) +------------+  batch  +--------+   TCP   +--------+
+ *   | Subject |------------->| MqttBridge |-------->| sender |-------->| Broker |
+ *   +---------+              |  Observer  |  deque  | thread |         +--------+
+ *                            +------------+         +--------+
+ *
+ * Пока сообщений нет, мост шлет PINGREQ раз в половину keep-alive, иначе
+ * брокер закроет молчащее соединение через полтора keep-alive.
+ *
+ * Для проверки без внешнего брокера рядом поднимается MockBroker на
+ * localhost, который понимает CONNECT/PUBLISH/PINGREQ/DISCONNECT протокола
+ * MQTT 3.1.1 и считает задержку доставки.
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <forward_list>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <set>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Объявляем базовый класс который будет выступать в роли интерфейса
+class BaseObserver {
+public:
+    // Обязательно при объявлении виртуальной функции
+    // создаем виртуальный деструктор
+    virtual ~BaseObserver() { }
+
+    virtual void notify() = 0;
+    virtual std::string getName() = 0;
+};
+
+class Observer : public BaseObserver {
+private:
+    std::string _name;
+
+public:
+    Observer(const std::string& name)
+        : _name(name)
+    {
+    }
+
+    void notify() override
+    {
+        std::cout << "Hello! I'm a " + getName() << std::endl;
+    }
+
+    std::string getName() override { return _name; }
+
+    static std::shared_ptr<Observer> make(std::string name)
+    {
+        return std::make_shared<Observer>(name);
+    }
+};
+
+// Субъект из предыдущего примера, только хранит интерфейс BaseObserver,
+// чтобы в список можно было положить мост в брокер.
+class Subject {
+public:
+    enum MessageTypes { DATA,
+        MQTT,
+        LOG,
+        ALL };
+
+private:
+    typedef std::forward_list<std::shared_ptr<BaseObserver>> ObserversList;
+    typedef std::map<int, ObserversList> ObserversMap;
+
+    ObserversMap _observers;
+
+public:
+    void addObserver(int messageTypes, std::shared_ptr<BaseObserver> observer)
+    {
+        _observers[messageTypes].push_front(observer);
+        std::cout << observer->getName() << " added to subscription on event #"
+                  << messageTypes << std::endl;
+    }
+
+    void notify(int event)
+    {
+        for (auto& mObserver : _observers) {
+            if (event == ALL || event == mObserver.first) {
+                for (auto& fObserver : mObserver.second) {
+                    fObserver->notify();
+                }
+            }
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Минимальное кодирование пакетов MQTT 3.1.1
+// ---------------------------------------------------------------------------
+namespace mqtt {
+
+enum PacketType : std::uint8_t {
+    CONNECT = 0x10,
+    CONNACK = 0x20,
+    PUBLISH = 0x30,
+    PINGREQ = 0xC0,
+    PINGRESP = 0xD0,
+    DISCONNECT = 0xE0
+};
+
+// Длина пакета кодируется переменным числом байт по 7 бит
+inline void putRemainingLength(std::string& out, std::size_t length)
+{
+    do {
+        auto byte = static_cast<std::uint8_t>(length % 128);
+        length /= 128;
+        if (length > 0) {
+            byte |= 0x80;
+        }
+        out.push_back(static_cast<char>(byte));
+    } while (length > 0);
+}
+
+inline void putString(std::string& out, std::string_view value)
+{
+    out.push_back(static_cast<char>(value.size() >> 8));
+    out.push_back(static_cast<char>(value.size() & 0xFF));
+    out.append(value);
+}
+
+inline void putConnect(std::string& out, std::string_view clientId,
+    std::uint16_t keepAliveSeconds)
+{
+    std::string body;
+    putString(body, "MQTT");
+    body.push_back(4); // Версия протокола 3.1.1
+    body.push_back(0x02); // Clean session
+    body.push_back(static_cast<char>(keepAliveSeconds >> 8));
+    body.push_back(static_cast<char>(keepAliveSeconds & 0xFF));
+    putString(body, clientId);
+
+    out.push_back(static_cast<char>(CONNECT));
+    putRemainingLength(out, body.size());
+    out.append(body);
+}
+
+// PUBLISH с QoS 0 дописывается в конец буфера, без лишних копий
+inline void putPublish(std::string& out, std::string_view topic,
+    std::string_view payload)
+{
+    out.push_back(static_cast<char>(PUBLISH));
+    putRemainingLength(out, 2 + topic.size() + payload.size());
+    putString(out, topic);
+    out.append(payload);
+}
+
+inline void putPingReq(std::string& out)
+{
+    out.push_back(static_cast<char>(PINGREQ));
+    out.push_back(0);
+}
+
+inline void putDisconnect(std::string& out)
+{
+    out.push_back(static_cast<char>(DISCONNECT));
+    out.push_back(0);
+}
+
+// Пишем буфер целиком. MSG_NOSIGNAL чтобы разрыв не убил процесс SIGPIPE.
+inline bool sendAll(int fd, std::string_view data)
+{
+    while (!data.empty()) {
+        ssize_t sent = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data.remove_prefix(static_cast<std::size_t>(sent));
+    }
+    return true;
+}
+
+inline bool recvAll(int fd, char* data, std::size_t size)
+{
+    while (size > 0) {
+        ssize_t got = recv(fd, data, size, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        size -= static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+inline std::uint64_t nowNs()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch())
+                                          .count());
+}
+
+} // namespace mqtt
+
+// ---------------------------------------------------------------------------
+// Мост в брокер
+// ---------------------------------------------------------------------------
+class MqttBridge {
+public:
+    struct Config {
+        std::string host = "127.0.0.1";
+        std::uint16_t port = 1883;
+        std::string clientId = "observer-bridge";
+        // Сколько самое старое сообщение может ждать отправки
+        std::chrono::microseconds linger = std::chrono::milliseconds(5);
+        std::size_t maxBatchMessages = 512;
+        std::size_t maxBatchBytes = 64 * 1024;
+        // Ограничение памяти: при переполнении выбрасываем самые старые
+        std::size_t maxBufferedMessages = 100'000;
+        std::chrono::milliseconds minBackoff = std::chrono::milliseconds(10);
+        std::chrono::milliseconds maxBackoff = std::chrono::milliseconds(1000);
+        // Keep-alive из CONNECT, 0 отключает PINGREQ и проверку брокером
+        std::chrono::seconds keepAlive = std::chrono::seconds(60);
+    };
+
+    struct Stats {
+        std::uint64_t published = 0;
+        std::uint64_t batches = 0;
+        std::uint64_t dropped = 0;
+        std::uint64_t reconnects = 0;
+    };
+
+private:
+    struct Message {
+        std::string topic;
+        std::string payload;
+        // Время поступления: linger считается от него, в том числе для
+        // сообщений, оставшихся после взятой пачки или вернувшихся в буфер
+        Clock::time_point enqueued;
+    };
+
+    Config _config;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<Message> _queue;
+    std::size_t _queuedBytes = 0;
+    bool _stopping = false;
+    Stats _stats;
+
+    int _fd = -1;
+    // Когда в сокет последний раз что-то ушло, от этого считается PINGREQ
+    Clock::time_point _lastSent;
+    std::thread _sender;
+
+    // Выбрасываем самые старые сообщения сверх лимита. Вызывать под _mutex.
+    void enforceBound()
+    {
+        while (_queue.size() > _config.maxBufferedMessages) {
+            _queuedBytes -= _queue.front().payload.size();
+            _queue.pop_front();
+            ++_stats.dropped;
+        }
+    }
+
+    bool batchReady() const
+    {
+        return _queue.size() >= _config.maxBatchMessages
+            || _queuedBytes >= _config.maxBatchBytes;
+    }
+
+    bool connectBroker()
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return false;
+        }
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(_config.port);
+        inet_pton(AF_INET, _config.host.c_str(), &addr.sin_addr);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return false;
+        }
+        // Пачки и так крупные, Nagle только добавит задержку
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        std::string packet;
+        mqtt::putConnect(packet, _config.clientId,
+            static_cast<std::uint16_t>(_config.keepAlive.count()));
+        char connack[4];
+        if (!mqtt::sendAll(fd, packet) || !mqtt::recvAll(fd, connack, sizeof(connack))
+            || static_cast<std::uint8_t>(connack[0]) != mqtt::CONNACK || connack[3] != 0) {
+            close(fd);
+            return false;
+        }
+        _fd = fd;
+        _lastSent = Clock::now();
+        return true;
+    }
+
+    // Брокер закрыл соединение? Проверяем до отправки пачки, иначе первая
+    // пачка после обрыва уйдет в мертвый сокет. При QoS 0 брокер присылает
+    // только PINGRESP, их здесь же и вычитываем, обычно это один вызов.
+    bool peerClosed()
+    {
+        char buffer[64];
+        for (;;) {
+            ssize_t got = recv(_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (got > 0 || (got < 0 && errno == EINTR)) {
+                continue;
+            }
+            return got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        }
+    }
+
+    // Соединение молчит уже половину keep-alive: шлем PINGREQ
+    void ping()
+    {
+        std::string packet;
+        mqtt::putPingReq(packet);
+        if (peerClosed() || !mqtt::sendAll(_fd, packet)) {
+            disconnectBroker();
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_stats.reconnects;
+            return;
+        }
+        _lastSent = Clock::now();
+    }
+
+    void disconnectBroker()
+    {
+        if (_fd >= 0) {
+            close(_fd);
+            _fd = -1;
+        }
+    }
+
+    // Возвращаем неотправленную пачку в начало буфера
+    void requeue(std::vector<Message>& batch)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+            _queuedBytes += it->payload.size();
+            _queue.push_front(std::move(*it));
+        }
+        batch.clear();
+        enforceBound();
+    }
+
+    void run()
+    {
+        std::vector<Message> batch;
+        std::string wire;
+        auto backoff = _config.minBackoff;
+
+        while (true) {
+            bool idle = false;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                auto hasWork = [this] { return _stopping || !_queue.empty(); };
+                if (_fd >= 0 && _config.keepAlive.count() > 0) {
+                    auto pingPeriod = std::chrono::milliseconds(_config.keepAlive) / 2;
+                    idle = !_cv.wait_until(lock, _lastSent + pingPeriod, hasWork);
+                } else {
+                    _cv.wait(lock, hasWork);
+                }
+            }
+            if (idle) {
+                ping();
+                continue;
+            }
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (_queue.empty()) {
+                    break; // Остановка и все отправлено
+                }
+                // Ждем пока наберется пачка, но самое старое сообщение
+                // не должно ждать дольше linger
+                _cv.wait_until(lock, _queue.front().enqueued + _config.linger,
+                    [this] { return _stopping || batchReady(); });
+
+                std::size_t bytes = 0;
+                while (!_queue.empty() && batch.size() < _config.maxBatchMessages
+                    && bytes < _config.maxBatchBytes) {
+                    bytes += _queue.front().payload.size();
+                    batch.push_back(std::move(_queue.front()));
+                    _queue.pop_front();
+                }
+                _queuedBytes -= bytes;
+            }
+
+            if (_fd >= 0 && peerClosed()) {
+                disconnectBroker();
+                std::lock_guard<std::mutex> lock(_mutex);
+                ++_stats.reconnects;
+            }
+            if (_fd < 0 && !connectBroker()) {
+                requeue(batch);
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (_stopping) {
+                    // Брокер недоступен, а нас закрывают: не висим вечно
+                    _stats.dropped += _queue.size();
+                    _queue.clear();
+                    _queuedBytes = 0;
+                    break;
+                }
+                _cv.wait_for(lock, backoff, [this] { return _stopping; });
+                backoff = std::min(backoff * 2, _config.maxBackoff);
+                continue;
+            }
+            backoff = _config.minBackoff;
+
+            // Вся пачка кодируется в один буфер и уходит одной записью
+            wire.clear();
+            for (auto& message : batch) {
+                mqtt::putPublish(wire, message.topic, message.payload);
+            }
+            if (!mqtt::sendAll(_fd, wire)) {
+                // QoS 0: что успело уйти до обрыва, может прийти повторно
+                disconnectBroker();
+                requeue(batch);
+                std::lock_guard<std::mutex> lock(_mutex);
+                ++_stats.reconnects;
+                continue;
+            }
+
+            _lastSent = Clock::now();
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.published += batch.size();
+            ++_stats.batches;
+            batch.clear();
+        }
+
+        if (_fd >= 0) {
+            std::string packet;
+            mqtt::putDisconnect(packet);
+            mqtt::sendAll(_fd, packet);
+            disconnectBroker();
+        }
+    }
+
+public:
+    MqttBridge(Config config)
+        : _config(std::move(config))
+    {
+        _sender = std::thread([this] { run(); });
+    }
+
+    MqttBridge(const MqttBridge&) = delete;
+    MqttBridge& operator=(const MqttBridge&) = delete;
+
+    // Отправляет все что осталось в буфере и закрывает соединение
+    ~MqttBridge()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _cv.notify_one();
+        _sender.join();
+    }
+
+    // Вызывается из notify(): кладем сообщение в буфер и сразу возвращаемся
+    void publish(std::string topic, std::string payload)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queuedBytes += payload.size();
+        _queue.push_back(Message { std::move(topic), std::move(payload), Clock::now() });
+        enforceBound();
+        // Будим отправителя только когда начался новый linger или набралась
+        // пачка, а не на каждое сообщение
+        if (_queue.size() == 1 || batchReady()) {
+            _cv.notify_one();
+        }
+    }
+
+    Stats stats()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+};
+
+// Наблюдатель-мост: подписывается на Subject как любой другой наблюдатель
+class MqttBridgeObserver : public BaseObserver {
+private:
+    std::shared_ptr<MqttBridge> _bridge;
+    std::string _topic;
+
+public:
+    MqttBridgeObserver(std::shared_ptr<MqttBridge> bridge, const std::string& topic)
+        : _bridge(std::move(bridge))
+        , _topic(topic)
+    {
+    }
+
+    // Полезная нагрузка несет время отправки, чтобы брокер мог посчитать задержку
+    void notify() override
+    {
+        _bridge->publish(_topic, std::to_string(mqtt::nowNs()));
+    }
+
+    std::string getName() override { return "MqttBridgeObserver(" + _topic + ")"; }
+
+    static std::shared_ptr<MqttBridgeObserver> make(
+        std::shared_ptr<MqttBridge> bridge, const std::string& topic)
+    {
+        return std::make_shared<MqttBridgeObserver>(std::move(bridge), topic);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Заглушка брокера на localhost. Принимает соединения, отвечает на CONNECT,
+// считает PUBLISH и задержку от notify() до получения.
+// ---------------------------------------------------------------------------
+class MockBroker {
+private:
+    int _listenFd = -1;
+    std::uint16_t _port = 0;
+    std::thread _acceptor;
+    std::vector<std::thread> _handlers;
+
+    std::mutex _mutex;
+    std::set<int> _clients;
+    // Задержка каждого полученного PUBLISH, наносекунды
+    std::vector<std::uint64_t> _latencies;
+    std::uint64_t _pings = 0;
+
+    void handle(int fd)
+    {
+        std::vector<std::uint64_t> latencies;
+        std::string buffer;
+        char chunk[64 * 1024];
+        bool open = true;
+
+        while (open) {
+            ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+            if (got <= 0) {
+                break;
+            }
+            buffer.append(chunk, static_cast<std::size_t>(got));
+
+            // Разбираем все целые пакеты в буфере
+            std::size_t pos = 0;
+            while (open) {
+                std::size_t length = 0, multiplier = 1, header = pos + 1;
+                bool complete = false;
+                while (header < buffer.size()) {
+                    auto byte = static_cast<std::uint8_t>(buffer[header++]);
+                    length += (byte & 0x7F) * multiplier;
+                    multiplier *= 128;
+                    if ((byte & 0x80) == 0) {
+                        complete = true;
+                        break;
+                    }
+                }
+                if (!complete || header + length > buffer.size()) {
+                    break;
+                }
+                auto type = static_cast<std::uint8_t>(buffer[pos]) & 0xF0;
+                std::string_view body(buffer.data() + header, length);
+                if (type == mqtt::CONNECT) {
+                    const char connack[4] = { static_cast<char>(mqtt::CONNACK), 2, 0, 0 };
+                    mqtt::sendAll(fd, std::string_view(connack, sizeof(connack)));
+                } else if (type == mqtt::PUBLISH) {
+                    std::size_t topicLength = (static_cast<std::uint8_t>(body[0]) << 8)
+                        | static_cast<std::uint8_t>(body[1]);
+                    std::string payload(body.substr(2 + topicLength));
+                    latencies.push_back(mqtt::nowNs() - std::stoull(payload));
+                } else if (type == mqtt::PINGREQ) {
+                    const char pingresp[2] = { static_cast<char>(mqtt::PINGRESP), 0 };
+                    mqtt::sendAll(fd, std::string_view(pingresp, sizeof(pingresp)));
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    ++_pings;
+                } else if (type == mqtt::DISCONNECT) {
+                    open = false;
+                }
+                pos = header + length;
+            }
+            buffer.erase(0, pos);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _latencies.insert(_latencies.end(), latencies.begin(), latencies.end());
+            latencies.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _clients.erase(fd);
+        close(fd);
+    }
+
+public:
+    MockBroker()
+    {
+        _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if (_listenFd < 0) {
+            throw std::system_error(errno, std::generic_category(), "socket");
+        }
+        int one = 1;
+        setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0; // Любой свободный порт
+        socklen_t size = sizeof(addr);
+        // Без проверки замер молча шел бы в мертвый порт
+        if (bind(_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+            || listen(_listenFd, 16) != 0
+            || getsockname(_listenFd, reinterpret_cast<sockaddr*>(&addr), &size) != 0) {
+            int error = errno;
+            close(_listenFd);
+            throw std::system_error(error, std::generic_category(), "mock broker listen");
+        }
+        _port = ntohs(addr.sin_port);
+
+        _acceptor = std::thread([this] {
+            while (true) {
+                int fd = accept(_listenFd, nullptr, nullptr);
+                if (fd < 0) {
+                    break;
+                }
+                std::lock_guard<std::mutex> lock(_mutex);
+                _clients.insert(fd);
+                _handlers.emplace_back([this, fd] { handle(fd); });
+            }
+        });
+    }
+
+    ~MockBroker()
+    {
+        shutdown(_listenFd, SHUT_RDWR);
+        close(_listenFd);
+        _acceptor.join();
+        dropConnections();
+        for (auto& handler : _handlers) {
+            handler.join();
+        }
+    }
+
+    std::uint16_t port() const { return _port; }
+
+    std::uint64_t received()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _latencies.size();
+    }
+
+    std::uint64_t pings()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _pings;
+    }
+
+    // Имитируем падение брокера: рвем все текущие соединения
+    void dropConnections()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (int fd : _clients) {
+            shutdown(fd, SHUT_RDWR);
+        }
+    }
+
+    // Перцентиль задержки в микросекундах
+    double latencyPercentile(double percentile)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_latencies.empty()) {
+            return 0;
+        }
+        auto nth = _latencies.begin()
+            + static_cast<std::ptrdiff_t>(percentile * static_cast<double>(_latencies.size() - 1));
+        std::nth_element(_latencies.begin(), nth, _latencies.end());
+        return static_cast<double>(*nth) / 1000.0;
+    }
+};
+
+// Замер: NOTIFIES уведомлений через Subject с заданными порогами пачки
+void benchmark(std::size_t maxBatchMessages, std::chrono::microseconds linger)
+{
+    constexpr int NOTIFIES = 200'000;
+    MockBroker broker;
+    auto start = Clock::now();
+    // Замер не должен зависнуть, если мост что-то потерял
+    auto deadline = start + std::chrono::seconds(30);
+    std::uint64_t published = 0;
+    {
+        MqttBridge::Config config;
+        config.port = broker.port();
+        config.maxBatchMessages = maxBatchMessages;
+        config.linger = linger;
+        // Буфер на весь замер, чтобы сравнение шло без потерь
+        config.maxBufferedMessages = NOTIFIES;
+        auto bridge = std::make_shared<MqttBridge>(config);
+
+        Subject subject;
+        subject.addObserver(Subject::MQTT, MqttBridgeObserver::make(bridge, "bench/mqtt"));
+        for (int i = 0; i < NOTIFIES; ++i) {
+            subject.notify(Subject::MQTT);
+        }
+        // Ждем пока мост отправит или выбросит все сообщения
+        while (Clock::now() < deadline) {
+            auto stats = bridge->stats();
+            published = stats.published;
+            if (stats.published + stats.dropped >= NOTIFIES) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    // Ждем пока брокер дочитает соединение, но только то, что мост отправил
+    while (broker.received() < published && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (published < NOTIFIES) {
+        std::cout << "bridge published only " << published << " of " << NOTIFIES
+                  << std::endl;
+    }
+    std::cout << "batch " << maxBatchMessages << ", linger " << linger.count()
+              << " us: " << static_cast<long>(NOTIFIES / seconds) << " msg/s, "
+              << "latency p50 " << broker.latencyPercentile(0.5) << " us, p99 "
+              << broker.latencyPercentile(0.99) << " us" << std::endl;
+}
+
+int main()
+{
+    MockBroker broker;
+    std::cout << "Mock broker listens on port " << broker.port() << std::endl;
+
+    MqttBridge::Config config;
+    config.port = broker.port();
+    config.maxBufferedMessages = 10'000;
+    auto bridge = std::make_shared<MqttBridge>(config);
+
+    Subject subject;
+    subject.addObserver(Subject::LOG, Observer::make("Observer1"));
+    subject.addObserver(Subject::MQTT, MqttBridgeObserver::make(bridge, "sensors/mqtt"));
+    std::cout << std::endl;
+
+    subject.notify(Subject::ALL);
+    for (int i = 0; i < 1000; ++i) {
+        subject.notify(Subject::MQTT);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Брокер "падает", мост переподключается и досылает буфер
+    std::cout << "\nDropping broker connections" << std::endl;
+    broker.dropConnections();
+    for (int i = 0; i < 1000; ++i) {
+        subject.notify(Subject::MQTT);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto stats = bridge->stats();
+    std::cout << "published " << stats.published << " in " << stats.batches
+              << " batches, reconnects " << stats.reconnects << ", dropped "
+              << stats.dropped << ", broker received " << broker.received()
+              << std::endl;
+
+    // Тишина дольше половины keep-alive: мост пингует брокер
+    {
+        MqttBridge::Config quiet;
+        quiet.port = broker.port();
+        quiet.clientId = "observer-bridge-quiet";
+        quiet.keepAlive = std::chrono::seconds(1);
+        MqttBridge idleBridge(quiet);
+        idleBridge.publish("sensors/idle", std::to_string(mqtt::nowNs()));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+        std::cout << "idle for 1.2 s with keep-alive 1 s, broker got "
+                  << broker.pings() << " PINGREQ" << std::endl;
+    }
+
+    // Сравнение: без пачек (по одной публикации) и с пачками разного размера
+    std::cout << "\nBenchmark" << std::endl;
+    benchmark(1, std::chrono::microseconds(0));
+    benchmark(64, std::chrono::microseconds(1000));
+    benchmark(512, std::chrono::microseconds(5000));
+
+    return 0;
+}
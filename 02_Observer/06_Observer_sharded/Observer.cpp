@@ -0,0 +1,614 @@
+/*
+ * Паттерн наблюдатель с разбиением субъекта на шарды по ядрам.
+ *
+ * Даже с правильной блокировкой один экземпляр Subject с одним списком
+ * подписчиков остается общей точкой конкуренции: каждый notify() с разных
+ * ядер трогает одну и ту же кэш-линию мьютекса, и она "скачет" между
+ * ядрами и сокетами.
+ *
+ * ShardedSubject держит по шарду на каждое доступное ядро:
+ *
+ *   +----------------------------------------------------------------+
+ *   | ShardedSubject                                                 |
+ *   |  +-----------+  +-----------+  +-----------+      +-----------+ |
+ *   |  | Shard 0   |  | Shard 1   |  | Shard 2   | ...  | Shard N-1 | |
+ *   |  | cpu 0     |  | cpu 1     |  | cpu 2     |      | cpu N-1   | |
+ *   |  | mutex     |  | mutex     |  | mutex     |      | mutex     | |
+ *   |  | map<list> |  | map<list> |  | map<list> |      | map<list> | |
+ *   |  | worker    |  | worker    |  | worker    |      | worker    | |
+ *   |  +-----------+  +-----------+  +-----------+      +-----------+ |
+ *   +----------------------------------------------------------------+
+ *
+ *   - addObserver() кладет наблюдателя в шард ядра, на котором работает
+ *     вызывающий поток (или в явно указанный шард);
+ *   - notifyLocal() уведомляет только шард своего ядра, не трогая чужие
+ *     кэш-линии, поэтому издатели на разных ядрах не мешают друг другу;
+ *   - notifyNode() уведомляет шарды своего NUMA узла;
+ *   - notifyAll() рассылает событие всем шардам параллельно: каждый шард
+ *     обходит свой список в своем потоке, привязанном к своему ядру.
+ *     Память шарда выделяет этот же поток, поэтому по правилу first-touch
+ *     она оказывается на NUMA узле своего ядра.
+ *
+ * Наблюдатель вызывается из потока своего шарда, поэтому его notify()
+ * должен быть потокобезопасным.
+ * Менять подписки из notify() можно: пока поток внутри рассылки, его
+ * addObserver()/removeObserver() откладываются (Subject::Subscriptions).
+ */
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <forward_list>
+#include <iostream>
+#include <latch>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Объявляем базовый класс который будет выступать в роли интерфейса
+class BaseObserver {
+public:
+    // Обязательно при объявлении виртуальной функции
+    // создаем виртуальный деструктор
+    virtual ~BaseObserver() { }
+
+    virtual void notify() = 0;
+    virtual std::string getName() = 0;
+};
+
+class Observer : public BaseObserver {
+private:
+    std::string _name;
+
+public:
+    Observer(const std::string& name)
+        : _name(name)
+    {
+    }
+
+    void notify() override
+    {
+        std::cout << "Hello! I'm a " + getName() + " on cpu "
+                + std::to_string(sched_getcpu()) + "\n";
+    }
+
+    std::string getName() override { return _name; }
+
+    static std::shared_ptr<Observer> make(std::string name)
+    {
+        return std::make_shared<Observer>(name);
+    }
+};
+
+// Субъект из предыдущего примера с одним мьютексом на все.
+// Нужен для сравнения в замере, его Subscriptions используют и шарды.
+class Subject {
+public:
+    enum MessageTypes { DATA,
+        MQTT,
+        LOG,
+        ALL };
+
+private:
+    typedef std::forward_list<std::shared_ptr<BaseObserver>> ObserversList;
+    typedef std::map<int, ObserversList> ObserversMap;
+
+public:
+    // Подписки под shared_mutex. Рассылка держит shared_lock, поэтому
+    // addObserver()/removeObserver() из notify() наблюдателя взяли бы unique_lock
+    // на мьютекс, который этот же поток уже держит, и зависли бы навсегда.
+    // Из чужого шарда тоже нельзя: два потока, рассылающие шарды 0 и 1 и
+    // меняющие подписки друг друга, ждали бы друг друга.
+    // Поэтому пока поток внутри любой рассылки, его изменения откладываются
+    // и применяются, когда он выйдет из самого внешнего notify().
+    // Изменения вне рассылки применяются сразу.
+    class Subscriptions {
+    private:
+        struct PendingChange {
+            bool add;
+            int messageTypes;
+            std::shared_ptr<BaseObserver> observer;
+        };
+
+        std::shared_mutex _mutex;
+        ObserversMap _observers;
+
+        std::mutex _pendingMutex;
+        std::vector<PendingChange> _pending;
+
+        // Глубина рассылок текущего потока (по всем подпискам)
+        static int& dispatchDepth()
+        {
+            static thread_local int depth = 0;
+            return depth;
+        }
+
+        // Подписки, в которые текущий поток отложил изменения
+        static std::vector<Subscriptions*>& deferred()
+        {
+            static thread_local std::vector<Subscriptions*> list;
+            return list;
+        }
+
+        // Отмечает поток как рассылающий. Деструктор срабатывает и при
+        // исключении из наблюдателя, после самой внешней рассылки применяет
+        // отложенное.
+        class DispatchGuard {
+        public:
+            DispatchGuard() { ++dispatchDepth(); }
+
+            ~DispatchGuard()
+            {
+                if (--dispatchDepth() == 0 && !deferred().empty()) {
+                    std::vector<Subscriptions*> list;
+                    list.swap(deferred());
+                    for (Subscriptions* subscriptions : list) {
+                        subscriptions->applyPending();
+                    }
+                }
+            }
+
+            DispatchGuard(const DispatchGuard&) = delete;
+            DispatchGuard& operator=(const DispatchGuard&) = delete;
+        };
+
+        // Вызывать под unique_lock
+        void apply(const PendingChange& change)
+        {
+            if (change.add) {
+                _observers[change.messageTypes].push_front(change.observer);
+                return;
+            }
+            auto it = _observers.find(change.messageTypes);
+            if (it != _observers.end()) {
+                it->second.remove(change.observer);
+            }
+        }
+
+        void change(PendingChange change)
+        {
+            if (dispatchDepth() > 0) {
+                {
+                    std::lock_guard<std::mutex> lock(_pendingMutex);
+                    _pending.push_back(std::move(change));
+                }
+                auto& list = deferred();
+                if (std::find(list.begin(), list.end(), this) == list.end()) {
+                    list.push_back(this);
+                }
+                return;
+            }
+            std::unique_lock lock(_mutex);
+            apply(change);
+        }
+
+        void applyPending()
+        {
+            std::vector<PendingChange> pending;
+            {
+                std::lock_guard<std::mutex> lock(_pendingMutex);
+                pending.swap(_pending);
+            }
+            std::unique_lock lock(_mutex);
+            for (auto& change : pending) {
+                apply(change);
+            }
+        }
+
+    public:
+        void add(int messageTypes, std::shared_ptr<BaseObserver> observer)
+        {
+            change({ true, messageTypes, std::move(observer) });
+        }
+
+        void remove(int messageTypes, const std::shared_ptr<BaseObserver>& observer)
+        {
+            change({ false, messageTypes, observer });
+        }
+
+        void notify(int event)
+        {
+            // guard объявлен раньше lock, поэтому отложенное применяется
+            // уже после того, как shared_lock отпущен
+            DispatchGuard guard;
+            std::shared_lock lock(_mutex);
+            for (auto& mObserver : _observers) {
+                if (event == ALL || event == mObserver.first) {
+                    for (auto& fObserver : mObserver.second) {
+                        fObserver->notify();
+                    }
+                }
+            }
+        }
+    };
+
+private:
+    Subscriptions _subscriptions;
+
+public:
+    void addObserver(int messageTypes, std::shared_ptr<BaseObserver> observer)
+    {
+        _subscriptions.add(messageTypes, std::move(observer));
+    }
+
+    void removeObserver(int messageTypes, std::shared_ptr<BaseObserver>& observer)
+    {
+        _subscriptions.remove(messageTypes, observer);
+        observer.reset();
+    }
+
+    void notify(int event) { _subscriptions.notify(event); }
+};
+
+namespace cpu {
+
+// Список ядер, на которых процессу разрешено работать
+inline std::vector<int> allowedCpus()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<int> cpus;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int i = 0; i < CPU_SETSIZE; ++i) {
+            if (CPU_ISSET(i, &set)) {
+                cpus.push_back(i);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        cpus.push_back(0);
+    }
+    return cpus;
+}
+
+// NUMA узел ядра: в /sys/devices/system/cpu/cpuN лежит ссылка nodeM.
+// Без NUMA (или без sysfs) считаем что узел один.
+inline int nodeOf(int cpu)
+{
+    std::error_code error;
+    std::filesystem::directory_iterator it(
+        "/sys/devices/system/cpu/cpu" + std::to_string(cpu), error);
+    for (; !error && it != std::filesystem::directory_iterator(); it.increment(error)) {
+        std::string name = it->path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4
+            && std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            return std::stoi(name.substr(4));
+        }
+    }
+    return 0;
+}
+
+inline void pinThisThread(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+} // namespace cpu
+
+class ShardedSubject {
+public:
+    typedef Subject::MessageTypes MessageTypes;
+
+private:
+    // Каждый шард в своих кэш-линиях, чтобы соседи не делили их (false sharing)
+    struct alignas(64) Shard {
+        int cpu = 0;
+        int node = 0;
+        Subject::Subscriptions subscriptions;
+
+        // Запрос на рассылку от notifyAll(): номер поколения и событие
+        alignas(64) std::atomic<std::uint32_t> generation { 0 };
+        int event = 0;
+
+        void notify(int topic) { subscriptions.notify(topic); }
+    };
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    // Номер ядра -> номер шарда
+    std::vector<int> _cpuToShard;
+    std::vector<std::thread> _workers;
+    bool _numaAware;
+
+    // Одна параллельная рассылка за раз, счетчик шардов которые еще работают
+    std::mutex _broadcastMutex;
+    alignas(64) std::atomic<std::uint32_t> _pending { 0 };
+    std::atomic<bool> _stopping { false };
+
+    void work(std::size_t index, std::latch& ready)
+    {
+        Shard& shard = *_shards[index];
+        std::uint32_t seen = 0;
+        ready.count_down();
+
+        while (true) {
+            shard.generation.wait(seen, std::memory_order_acquire);
+            seen = shard.generation.load(std::memory_order_acquire);
+            if (_stopping.load(std::memory_order_acquire)) {
+                break;
+            }
+            shard.notify(shard.event);
+            if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                _pending.notify_one();
+            }
+        }
+    }
+
+public:
+    // numaAware включает привязку потоков шардов к их ядрам и выделение
+    // памяти шарда на его NUMA узле. Без нее шарды все равно разделены
+    // по ядрам, но потоки планировщик ставит куда хочет.
+    ShardedSubject(bool numaAware = true)
+        : _numaAware(numaAware)
+    {
+        std::vector<int> cpus = cpu::allowedCpus();
+        _cpuToShard.assign(static_cast<std::size_t>(cpus.back()) + 1, 0);
+        _shards.resize(cpus.size());
+
+        std::latch ready(static_cast<std::ptrdiff_t>(cpus.size()));
+        for (std::size_t i = 0; i < cpus.size(); ++i) {
+            _cpuToShard[static_cast<std::size_t>(cpus[i])] = static_cast<int>(i);
+            _workers.emplace_back([this, i, cpuId = cpus[i], &ready] {
+                // Сначала привязываемся к ядру, потом выделяем память шарда
+                if (_numaAware) {
+                    cpu::pinThisThread(cpuId);
+                }
+                auto shard = std::make_unique<Shard>();
+                shard->cpu = cpuId;
+                shard->node = cpu::nodeOf(cpuId);
+                _shards[i] = std::move(shard);
+                work(i, ready);
+            });
+        }
+        ready.wait();
+    }
+
+    ShardedSubject(const ShardedSubject&) = delete;
+    ShardedSubject& operator=(const ShardedSubject&) = delete;
+
+    ~ShardedSubject()
+    {
+        _stopping.store(true, std::memory_order_release);
+        for (auto& shard : _shards) {
+            shard->generation.fetch_add(1, std::memory_order_release);
+            shard->generation.notify_one();
+        }
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    std::size_t shardCount() const { return _shards.size(); }
+
+    // Шард ядра, на котором сейчас работает вызывающий поток
+    std::size_t localShard() const
+    {
+        int current = sched_getcpu();
+        if (current < 0 || static_cast<std::size_t>(current) >= _cpuToShard.size()) {
+            return 0;
+        }
+        return static_cast<std::size_t>(_cpuToShard[static_cast<std::size_t>(current)]);
+    }
+
+    // Добавляем наблюдателя в шард текущего ядра
+    void addObserver(int messageTypes, std::shared_ptr<BaseObserver> observer)
+    {
+        addObserver(localShard(), messageTypes, std::move(observer));
+    }
+
+    void addObserver(std::size_t shardIndex, int messageTypes,
+        std::shared_ptr<BaseObserver> observer)
+    {
+        _shards[shardIndex % _shards.size()]->subscriptions.add(messageTypes,
+            std::move(observer));
+    }
+
+    void removeObserver(int messageTypes, std::shared_ptr<BaseObserver>& observer)
+    {
+        for (auto& shard : _shards) {
+            shard->subscriptions.remove(messageTypes, observer);
+        }
+        observer.reset();
+    }
+
+    // Уведомляем только наблюдателей своего ядра
+    void notifyLocal(int event) { _shards[localShard()]->notify(event); }
+
+    // Уведомляем шарды своего NUMA узла, в вызывающем потоке
+    void notifyNode(int event)
+    {
+        int node = _shards[localShard()]->node;
+        for (auto& shard : _shards) {
+            if (shard->node == node) {
+                shard->notify(event);
+            }
+        }
+    }
+
+    // Рассылаем всем шардам параллельно и ждем пока все закончат
+    void notifyAll(int event)
+    {
+        std::lock_guard<std::mutex> lock(_broadcastMutex);
+        _pending.store(static_cast<std::uint32_t>(_shards.size()),
+            std::memory_order_relaxed);
+        for (auto& shard : _shards) {
+            shard->event = event;
+            shard->generation.fetch_add(1, std::memory_order_release);
+            shard->generation.notify_one();
+        }
+        for (std::uint32_t left = _pending.load(std::memory_order_acquire); left != 0;
+             left = _pending.load(std::memory_order_acquire)) {
+            _pending.wait(left, std::memory_order_acquire);
+        }
+    }
+
+    // То же самое, но по очереди в вызывающем потоке
+    void notifyAllSequential(int event)
+    {
+        for (auto& shard : _shards) {
+            shard->notify(event);
+        }
+    }
+};
+
+// Наблюдатель, который из своего notify() подписывает новичка и
+// отписывается сам. Без отложенных изменений поток завис бы на мьютексе
+// шарда, который он же держит на время рассылки.
+class Recruiter : public Observer {
+private:
+    ShardedSubject& _subject;
+    std::shared_ptr<BaseObserver> _recruit;
+    std::shared_ptr<BaseObserver> _self;
+
+public:
+    Recruiter(const std::string& name, ShardedSubject& subject,
+        std::shared_ptr<BaseObserver> recruit)
+        : Observer(name)
+        , _subject(subject)
+        , _recruit(std::move(recruit))
+    {
+    }
+
+    void setSelf(std::shared_ptr<BaseObserver> self) { _self = std::move(self); }
+
+    void notify() override
+    {
+        Observer::notify();
+        if (_recruit) {
+            _subject.addObserver(0, Subject::MQTT, std::move(_recruit));
+            _subject.removeObserver(Subject::MQTT, _self);
+        }
+    }
+};
+
+// Наблюдатель для замера: счетчик в своей кэш-линии
+class CountingObserver : public BaseObserver {
+private:
+    alignas(64) std::atomic<std::uint64_t> _count { 0 };
+
+public:
+    void notify() override { _count.fetch_add(1, std::memory_order_relaxed); }
+
+    std::string getName() override { return "CountingObserver"; }
+
+    std::uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+};
+
+// Замер пропускной способности notify() из threads потоков, по потоку на ядро
+template <typename Notify>
+double measure(std::size_t threads, const std::vector<int>& cpus, Notify notify)
+{
+    constexpr int NOTIFIES = 1'000'000;
+    std::latch start(static_cast<std::ptrdiff_t>(threads) + 1);
+    std::vector<std::thread> publishers;
+    for (std::size_t t = 0; t < threads; ++t) {
+        publishers.emplace_back([&, t] {
+            cpu::pinThisThread(cpus[t % cpus.size()]);
+            start.arrive_and_wait();
+            for (int i = 0; i < NOTIFIES; ++i) {
+                notify();
+            }
+        });
+    }
+    auto begin = std::chrono::steady_clock::now();
+    start.arrive_and_wait();
+    for (auto& publisher : publishers) {
+        publisher.join();
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin)
+                         .count();
+    return static_cast<double>(threads * NOTIFIES) / seconds;
+}
+
+int main()
+{
+    ShardedSubject subject;
+    std::cout << "Sharded subject with " << subject.shardCount() << " shards"
+              << std::endl;
+
+    // Каждому шарду по наблюдателю на LOG и DATA
+    for (std::size_t i = 0; i < subject.shardCount(); ++i) {
+        subject.addObserver(i, Subject::LOG,
+            Observer::make("LogObserver" + std::to_string(i)));
+        subject.addObserver(i, Subject::DATA,
+            Observer::make("DataObserver" + std::to_string(i)));
+    }
+
+    std::cout << "\nnotifyLocal(LOG)" << std::endl;
+    subject.notifyLocal(Subject::LOG);
+    std::cout << "\nnotifyNode(DATA)" << std::endl;
+    subject.notifyNode(Subject::DATA);
+    std::cout << "\nnotifyAll(ALL)" << std::endl;
+    subject.notifyAll(Subject::ALL);
+
+    // Подписки меняются прямо из рассылки
+    auto recruiter = std::make_shared<Recruiter>("Recruiter", subject,
+        Observer::make("Recruit"));
+    recruiter->setSelf(recruiter);
+    subject.addObserver(0, Subject::MQTT, recruiter);
+    recruiter.reset();
+    std::cout << "\nnotifyAll(MQTT) twice" << std::endl;
+    subject.notifyAll(Subject::MQTT);
+    subject.notifyAll(Subject::MQTT);
+
+    // Масштабирование: один Subject на всех против шарда на ядро
+    std::cout << "\nBenchmark, notifications per second" << std::endl;
+    std::vector<int> cpus = cpu::allowedCpus();
+
+    Subject single;
+    auto singleCounter = std::make_shared<CountingObserver>();
+    single.addObserver(Subject::DATA, singleCounter);
+
+    ShardedSubject sharded;
+    std::vector<std::shared_ptr<CountingObserver>> counters;
+    for (std::size_t i = 0; i < sharded.shardCount(); ++i) {
+        counters.push_back(std::make_shared<CountingObserver>());
+        sharded.addObserver(i, Subject::DATA, counters.back());
+    }
+
+    std::vector<std::size_t> threadCounts;
+    for (std::size_t t = 1; t < cpus.size(); t *= 2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(cpus.size());
+
+    for (std::size_t threads : threadCounts) {
+        double baseline = measure(threads, cpus, [&] { single.notify(Subject::DATA); });
+        double local = measure(threads, cpus, [&] { sharded.notifyLocal(Subject::DATA); });
+        std::cout << threads << " threads: single Subject "
+                  << static_cast<long>(baseline) << ", sharded notifyLocal "
+                  << static_cast<long>(local) << std::endl;
+    }
+
+    // Рассылка по всем шардам: по очереди в одном потоке против параллельной
+    constexpr int BROADCASTS = 10'000;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < BROADCASTS; ++i) {
+        sharded.notifyAllSequential(Subject::DATA);
+    }
+    double sequential = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin)
+                            .count();
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < BROADCASTS; ++i) {
+        sharded.notifyAll(Subject::DATA);
+    }
+    double parallel = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin)
+                          .count();
+    std::cout << "broadcast to " << sharded.shardCount() << " shards: sequential "
+              << sequential / BROADCASTS * 1e6 << " us, parallel "
+              << parallel / BROADCASTS * 1e6 << " us" << std::endl;
+
+    return 0;
+}
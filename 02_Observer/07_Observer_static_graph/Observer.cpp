@@ -0,0 +1,390 @@
+/*
+ * Паттерн наблюдатель со связями, заданными на этапе компиляции.
+ *
+ * Многие подписки известны заранее и не меняются во время работы, но каждый
+ * notify() все равно ищет топик в std::map, идет по forward_list и вызывает
+ * виртуальный BaseObserver::notify(). Если граф подписок описать типами,
+ * компилятор может развернуть notify<Topic>() в прямые вызовы, которые
+ * легко встраиваются (inline):
+ *
+ *   StaticSubject<
+ *       ObserverSet<Logger, Counter, Mirror>,     // экземпляры наблюдателей
+ *       Route<Subject::DATA, Counter, Mirror>,    // DATA -> Counter, Mirror
+ *       Route<Subject::LOG, Logger>>              // LOG  -> Logger
+ *
+ *   notify<Subject::DATA>()  ==>  counter.notify(); mirror.notify();
+ *
+ * StaticSubject наследуется от обычного Subject, поэтому динамических
+ * наблюдателей по-прежнему можно добавлять через addObserver(): они
+ * уведомляются после статических.
+ */
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <forward_list>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Объявляем базовый класс который будет выступать в роли интерфейса
+class BaseObserver {
+public:
+    // Обязательно при объявлении виртуальной функции
+    // создаем виртуальный деструктор
+    virtual ~BaseObserver() { }
+
+    virtual void notify() = 0;
+    virtual std::string getName() = 0;
+};
+
+class Observer : public BaseObserver {
+private:
+    std::string _name;
+
+public:
+    Observer(const std::string& name)
+        : _name(name)
+    {
+    }
+
+    void notify() override
+    {
+        std::cout << "Hello! I'm a " + getName() << std::endl;
+    }
+
+    std::string getName() override { return _name; }
+
+    static std::shared_ptr<Observer> make(std::string name)
+    {
+        return std::make_shared<Observer>(name);
+    }
+};
+
+// Субъект из предыдущего примера для динамических подписок
+class Subject {
+public:
+    enum MessageTypes { DATA,
+        MQTT,
+        LOG,
+        ALL };
+
+protected:
+    typedef std::forward_list<std::shared_ptr<BaseObserver>> ObserversList;
+    typedef std::map<int, ObserversList> ObserversMap;
+
+    ObserversMap _observers;
+
+private:
+    // Изменение подписки, отложенное до конца рассылки
+    struct PendingChange {
+        bool add;
+        int messageTypes;
+        std::shared_ptr<BaseObserver> observer;
+    };
+    std::vector<PendingChange> _pending;
+    // Глубина вложенных вызовов notify
+    int _dispatchDepth = 0;
+
+    void applyAdd(int messageTypes, std::shared_ptr<BaseObserver> observer)
+    {
+        _observers[messageTypes].push_front(observer);
+        std::cout << observer->getName() << " added to subscription on event #"
+                  << messageTypes << std::endl;
+    }
+
+    void applyRemove(int messageTypes, std::shared_ptr<BaseObserver>& observer)
+    {
+        auto it = _observers.find(messageTypes);
+        if (it != _observers.end()) {
+            it->second.remove(observer);
+        }
+        observer.reset();
+    }
+
+    // Применяем все накопленные изменения одной пачкой
+    void applyPending()
+    {
+        std::vector<PendingChange> pending;
+        pending.swap(_pending);
+        for (auto& change : pending) {
+            if (change.add) {
+                applyAdd(change.messageTypes, change.observer);
+            } else {
+                applyRemove(change.messageTypes, change.observer);
+            }
+        }
+    }
+
+    // Отмечает рассылку на время notify(). Деструктор срабатывает и при
+    // исключении из наблюдателя, поэтому глубина не "застревает" и
+    // отложенные изменения все равно применяются.
+    class DispatchGuard {
+    private:
+        Subject& _subject;
+
+    public:
+        explicit DispatchGuard(Subject& subject)
+            : _subject(subject)
+        {
+            ++_subject._dispatchDepth;
+        }
+
+        ~DispatchGuard()
+        {
+            if (--_subject._dispatchDepth == 0 && !_subject._pending.empty()) {
+                _subject.applyPending();
+            }
+        }
+
+        DispatchGuard(const DispatchGuard&) = delete;
+        DispatchGuard& operator=(const DispatchGuard&) = delete;
+    };
+
+public:
+    virtual ~Subject() { }
+
+    // Во время рассылки изменения подписки откладываются до выхода
+    // из самого внешнего notify()
+    void addObserver(int messageTypes, std::shared_ptr<BaseObserver> observer)
+    {
+        if (_dispatchDepth > 0) {
+            _pending.push_back({ true, messageTypes, observer });
+            return;
+        }
+        applyAdd(messageTypes, observer);
+    }
+
+    void removeObserver(int messageTypes, std::shared_ptr<BaseObserver>& observer)
+    {
+        if (_dispatchDepth > 0) {
+            _pending.push_back({ false, messageTypes, observer });
+            observer.reset();
+            return;
+        }
+        applyRemove(messageTypes, observer);
+    }
+
+    virtual void notify(int event)
+    {
+        DispatchGuard guard(*this);
+        for (auto& mObserver : _observers) {
+            if (event == ALL || event == mObserver.first) {
+                for (auto& fObserver : mObserver.second) {
+                    fObserver->notify();
+                }
+            }
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Описание графа на типах
+// ---------------------------------------------------------------------------
+
+// Статическому наблюдателю не нужен базовый класс, достаточно метода notify()
+template <typename T>
+concept StaticObserver = requires(T observer) {
+    observer.notify();
+};
+
+// Набор наблюдателей: StaticSubject хранит по одному экземпляру каждого типа
+template <StaticObserver... Observers>
+struct ObserverSet { };
+
+// Ребро графа: топик и наблюдатели, которых он уведомляет
+template <int Topic, StaticObserver... Observers>
+struct Route {
+    static constexpr int topic = Topic;
+};
+
+template <typename Set, typename... Routes>
+class StaticSubject;
+
+template <typename... Observers, typename... Routes>
+class StaticSubject<ObserverSet<Observers...>, Routes...> : public Subject {
+private:
+    template <typename T>
+    static constexpr bool isDeclared = (std::is_same_v<T, Observers> || ...);
+
+    // Каждый тип из Route должен быть объявлен в ObserverSet
+    template <int Topic, typename... RouteTypes>
+    static constexpr bool routeIsDeclared(Route<Topic, RouteTypes...>)
+    {
+        return (isDeclared<RouteTypes> && ...);
+    }
+
+    static_assert((routeIsDeclared(Routes {}) && ...),
+        "Route uses an observer that is not listed in ObserverSet");
+    static_assert(((Routes::topic != ALL) && ...), "Route topic ALL is reserved");
+
+    std::tuple<Observers...> _static;
+
+    template <int Topic, typename... RouteTypes>
+    void notifyRoute(Route<Topic, RouteTypes...>)
+    {
+        (std::get<RouteTypes>(_static).notify(), ...);
+    }
+
+    // Для notify<Event>() отбор маршрутов происходит при компиляции
+    template <int Event, int Topic, typename... RouteTypes>
+    void notifyIfMatches(Route<Topic, RouteTypes...> route)
+    {
+        if constexpr (Event == ALL || Event == Topic) {
+            notifyRoute(route);
+        }
+    }
+
+    void notifyDynamic(int event)
+    {
+        // Пустая карта ничего не стоит кроме одной проверки
+        if (!_observers.empty()) {
+            Subject::notify(event);
+        }
+    }
+
+public:
+    StaticSubject() = default;
+
+    // Наблюдатели с состоянием можно сконструировать снаружи
+    explicit StaticSubject(Observers... observers)
+        : _static(std::move(observers)...)
+    {
+    }
+
+    // Доступ к экземпляру статического наблюдателя
+    template <typename T>
+    T& get()
+    {
+        static_assert(isDeclared<T>, "Observer is not listed in ObserverSet");
+        return std::get<T>(_static);
+    }
+
+    // Топик известен при компиляции: прямые вызовы без поиска и виртуальности
+    template <int Event>
+    void notify()
+    {
+        (notifyIfMatches<Event>(Routes {}), ...);
+        notifyDynamic(Event);
+    }
+
+    // Топик известен только во время работы: сравнение с константами
+    // маршрутов вместо поиска в map, вызовы все равно прямые
+    void notify(int event) override
+    {
+        ((event == ALL || event == Routes::topic ? notifyRoute(Routes {}) : void()),
+            ...);
+        notifyDynamic(event);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Статические наблюдатели: обычные классы без виртуальных методов
+// ---------------------------------------------------------------------------
+class Logger {
+public:
+    void notify() { std::cout << "Hello! I'm a static Logger" << std::endl; }
+};
+
+class Mirror {
+public:
+    void notify() { std::cout << "Hello! I'm a static Mirror" << std::endl; }
+};
+
+class Counter {
+private:
+    std::uint64_t _count = 0;
+
+public:
+    void notify() { ++_count; }
+    std::uint64_t count() const { return _count; }
+};
+
+// Тот же счетчик для динамической подписки, для сравнения
+class CountingObserver : public BaseObserver {
+private:
+    std::uint64_t _count = 0;
+
+public:
+    void notify() override { ++_count; }
+    std::string getName() override { return "CountingObserver"; }
+    std::uint64_t count() const { return _count; }
+};
+
+// Объект "утекает" к неизвестному коду: компилятор обязан считать, что его
+// прочитали и изменили, и не может выкинуть или объединить записи в него
+template <typename T>
+inline void escape(T& object)
+{
+    asm volatile("" : : "r"(&object) : "memory");
+}
+
+int main()
+{
+    StaticSubject<ObserverSet<Logger, Mirror, Counter>,
+        Route<Subject::DATA, Counter, Mirror>,
+        Route<Subject::LOG, Logger>>
+        subject;
+
+    // Динамические подписки продолжают работать
+    subject.addObserver(Subject::LOG, Observer::make("Observer1"));
+    subject.addObserver(Subject::MQTT, Observer::make("Observer2"));
+    std::cout << std::endl;
+
+    std::cout << "notify<LOG>()" << std::endl;
+    subject.notify<Subject::LOG>();
+    std::cout << "\nnotify<DATA>()" << std::endl;
+    subject.notify<Subject::DATA>();
+    std::cout << "\nnotify(ALL) through Subject&" << std::endl;
+    Subject& dynamic = subject;
+    dynamic.notify(Subject::ALL);
+    std::cout << "Counter saw " << subject.get<Counter>().count()
+              << " DATA events" << std::endl;
+
+    // Сравнение: 4 счетчика в динамическом Subject против 4 в статическом графе
+    constexpr int NOTIFIES = 10'000'000;
+    Subject runtime;
+    std::shared_ptr<CountingObserver> counters[4];
+    for (auto& counter : counters) {
+        counter = std::make_shared<CountingObserver>();
+        runtime.addObserver(Subject::DATA, counter);
+    }
+
+    struct C1 : Counter { };
+    struct C2 : Counter { };
+    struct C3 : Counter { };
+    struct C4 : Counter { };
+    StaticSubject<ObserverSet<C1, C2, C3, C4>, Route<Subject::DATA, C1, C2, C3, C4>>
+        compiled;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NOTIFIES; ++i) {
+        runtime.notify(Subject::DATA);
+        escape(runtime);
+    }
+    double runtimeNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start)
+                           .count();
+
+    // Без escape() компилятор в Release видит все вызовы насквозь и сворачивает
+    // цикл в четыре сложения. escape() заставляет записывать счетчики в память
+    // на каждой итерации, поэтому замеряется сама рассылка.
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NOTIFIES; ++i) {
+        compiled.notify<Subject::DATA>();
+        escape(compiled);
+    }
+    double compiledNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start)
+                            .count();
+
+    std::cout << "\nruntime Subject: " << runtimeNs / NOTIFIES
+              << " ns/notify, static graph: " << compiledNs / NOTIFIES
+              << " ns/notify (counts " << counters[0]->count() << " / "
+              << compiled.get<C1>().count() << ")" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,529 @@
+/*
+ * Паттерн наблюдатель с отложенными и периодическими уведомлениями.
+ *
+ * Вместо внешних таймеров и отдельного потока на каждое расписание
+ * (heartbeat в DATA, отложенные события в LOG) все расписания живут
+ * в иерархическом колесе таймеров (hierarchical timing wheel), которое
+ * крутит один поток.
+ *
+ * Колесо из 4 уровней по 256 слотов, один слот нулевого уровня это один
+ * тик. Каждый следующий уровень в 256 раз грубее предыдущего:
+ *
+ *   уровень 3: [  0 ][  1 ] ... [255]   слот = 2^24 тиков
+ *   уровень 2: [  0 ][  1 ] ... [255]   слот = 2^16 тиков
+ *   уровень 1: [  0 ][  1 ] ... [255]   слот = 256 тиков
+ *   уровень 0: [  0 ][  1 ] ... [255]   слот = 1 тик
+ *                 |
+ *                 v
+ *              таймер <-> таймер <-> таймер   (двусвязный список)
+ *
+ *   - добавление: по времени срабатывания сразу вычисляется уровень и слот,
+ *     таймер добавляется в голову списка слота, O(1);
+ *   - отмена: таймер знает свой слот и соседей, вынимается из списка, O(1);
+ *   - когда нулевой уровень проходит полный круг, слот следующего уровня
+ *     "осыпается" (cascade): его таймеры раскладываются по уровням ниже.
+ *
+ * Таймеры лежат в одном пуле (вектор с freelist) с заранее заданной
+ * емкостью, поэтому память ограничена, а миллионы таймеров не дают
+ * миллионов отдельных выделений памяти.
+ */
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <forward_list>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Объявляем базовый класс который будет выступать в роли интерфейса
+class BaseObserver {
+public:
+    // Обязательно при объявлении виртуальной функции
+    // создаем виртуальный деструктор
+    virtual ~BaseObserver() { }
+
+    virtual void notify() = 0;
+    virtual std::string getName() = 0;
+};
+
+class Observer : public BaseObserver {
+private:
+    std::string _name;
+    std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+
+public:
+    Observer(const std::string& name)
+        : _name(name)
+    {
+    }
+
+    void notify() override
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - _start);
+        std::cout << "Hello! I'm a " + getName() + " at " << elapsed.count()
+                  << " ms" << std::endl;
+    }
+
+    std::string getName() override { return _name; }
+
+    static std::shared_ptr<Observer> make(std::string name)
+    {
+        return std::make_shared<Observer>(name);
+    }
+};
+
+// Субъект из предыдущего примера. notify() вызывается из потока таймеров,
+// а подписываться можно из любого потока, поэтому карта под мьютексом.
+// Наблюдатели вызываются по копии списка без блокировки: так они могут
+// сами подписываться, а медленный наблюдатель не держит addObserver().
+class Subject {
+public:
+    enum MessageTypes { DATA,
+        MQTT,
+        LOG,
+        ALL };
+
+private:
+    typedef std::forward_list<std::shared_ptr<BaseObserver>> ObserversList;
+    typedef std::map<int, ObserversList> ObserversMap;
+
+    std::mutex _mutex;
+    ObserversMap _observers;
+
+public:
+    void addObserver(int messageTypes, std::shared_ptr<BaseObserver> observer)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _observers[messageTypes].push_front(observer);
+        }
+        std::cout << observer->getName() << " added to subscription on event #"
+                  << messageTypes << std::endl;
+    }
+
+    void notify(int event)
+    {
+        std::vector<std::shared_ptr<BaseObserver>> observers;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto& mObserver : _observers) {
+                if (event == ALL || event == mObserver.first) {
+                    observers.insert(observers.end(), mObserver.second.begin(),
+                        mObserver.second.end());
+                }
+            }
+        }
+        for (auto& fObserver : observers) {
+            fObserver->notify();
+        }
+    }
+};
+
+// Идентификатор таймера: поколение в старших 32 битах, номер в пуле в младших.
+// Поколение защищает от отмены чужого таймера по устаревшему идентификатору.
+typedef std::uint64_t TimerId;
+constexpr TimerId INVALID_TIMER = 0;
+
+// ---------------------------------------------------------------------------
+// Само колесо, без потоков и блокировок. Время измеряется в тиках.
+// ---------------------------------------------------------------------------
+class TimingWheel {
+private:
+    static constexpr unsigned LEVELS = 4;
+    static constexpr unsigned BITS = 8;
+    static constexpr unsigned SLOTS = 1u << BITS;
+    static constexpr unsigned MASK = SLOTS - 1;
+    static constexpr std::uint32_t NIL = ~std::uint32_t(0);
+    // Дальше этого горизонта таймер ставится на последний уровень
+    // и пересчитывается при осыпании
+    static constexpr std::uint64_t HORIZON = (std::uint64_t(1) << (BITS * LEVELS)) - 1;
+
+    struct Node {
+        std::uint64_t expires = 0;
+        std::uint32_t period = 0; // 0 - одноразовый таймер
+        std::uint32_t generation = 1;
+        std::uint32_t prev = NIL;
+        std::uint32_t next = NIL; // В свободном таймере - следующий свободный
+        std::uint16_t slot = 0; // level * SLOTS + index
+        bool linked = false;
+        int topic = 0;
+    };
+
+    std::vector<Node> _nodes;
+    std::size_t _capacity;
+    std::uint32_t _free = NIL;
+    std::array<std::uint32_t, LEVELS * SLOTS> _heads;
+    // Занятые слоты нулевого уровня, чтобы быстро найти следующее событие
+    std::array<std::uint64_t, SLOTS / 64> _occupied {};
+    std::uint64_t _now = 0;
+    std::size_t _active = 0;
+
+    void link(std::uint32_t index)
+    {
+        Node& node = _nodes[index];
+        std::uint64_t delta = std::min(node.expires - _now, HORIZON);
+        std::uint64_t expires = _now + delta;
+        unsigned level = 0;
+        while (level + 1 < LEVELS && delta >= (std::uint64_t(1) << (BITS * (level + 1)))) {
+            ++level;
+        }
+        unsigned slot = level * SLOTS
+            + static_cast<unsigned>((expires >> (BITS * level)) & MASK);
+
+        node.slot = static_cast<std::uint16_t>(slot);
+        node.prev = NIL;
+        node.next = _heads[slot];
+        if (node.next != NIL) {
+            _nodes[node.next].prev = index;
+        }
+        _heads[slot] = index;
+        node.linked = true;
+        if (level == 0) {
+            _occupied[slot / 64] |= std::uint64_t(1) << (slot % 64);
+        }
+    }
+
+    void unlink(std::uint32_t index)
+    {
+        Node& node = _nodes[index];
+        if (node.prev != NIL) {
+            _nodes[node.prev].next = node.next;
+        } else {
+            _heads[node.slot] = node.next;
+        }
+        if (node.next != NIL) {
+            _nodes[node.next].prev = node.prev;
+        }
+        if (node.slot < SLOTS && _heads[node.slot] == NIL) {
+            _occupied[node.slot / 64] &= ~(std::uint64_t(1) << (node.slot % 64));
+        }
+        node.linked = false;
+    }
+
+    void release(std::uint32_t index)
+    {
+        Node& node = _nodes[index];
+        ++node.generation;
+        if (node.generation == 0) {
+            node.generation = 1;
+        }
+        node.next = _free;
+        _free = index;
+        --_active;
+    }
+
+    // Забираем весь список слота и раскладываем таймеры заново
+    void cascade(unsigned level, unsigned index)
+    {
+        unsigned slot = level * SLOTS + index;
+        std::uint32_t current = _heads[slot];
+        _heads[slot] = NIL;
+        while (current != NIL) {
+            std::uint32_t next = _nodes[current].next;
+            link(current);
+            current = next;
+        }
+    }
+
+public:
+    // Пул резервируется сразу: память не растет после создания, а ссылки
+    // на таймеры не становятся висячими, если schedule() зовут из fire()
+    TimingWheel(std::size_t capacity)
+        : _capacity(capacity)
+    {
+        _nodes.reserve(capacity);
+        _heads.fill(NIL);
+    }
+
+    std::uint64_t now() const { return _now; }
+    std::size_t size() const { return _active; }
+    std::size_t capacity() const { return _capacity; }
+    std::size_t memoryBytes() const { return _nodes.capacity() * sizeof(Node) + sizeof(*this); }
+
+    // Таймер сработает через delay тиков (не меньше одного), затем каждые
+    // period тиков. Если пул заполнен, возвращает INVALID_TIMER.
+    TimerId schedule(int topic, std::uint64_t delay, std::uint32_t period = 0)
+    {
+        std::uint32_t index;
+        if (_free != NIL) {
+            index = _free;
+            _free = _nodes[index].next;
+        } else if (_nodes.size() < _capacity) {
+            index = static_cast<std::uint32_t>(_nodes.size());
+            _nodes.emplace_back();
+        } else {
+            return INVALID_TIMER;
+        }
+        Node& node = _nodes[index];
+        node.expires = _now + std::max<std::uint64_t>(delay, 1);
+        node.period = period;
+        node.topic = topic;
+        link(index);
+        ++_active;
+        return (TimerId(node.generation) << 32) | index;
+    }
+
+    bool cancel(TimerId id)
+    {
+        auto index = static_cast<std::uint32_t>(id);
+        auto generation = static_cast<std::uint32_t>(id >> 32);
+        if (index >= _nodes.size() || _nodes[index].generation != generation
+            || !_nodes[index].linked) {
+            return false;
+        }
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    // Ближайший тик, на котором колесу есть что делать: занятый слот
+    // нулевого уровня или граница круга, где осыпается следующий уровень
+    std::uint64_t nextEventTick() const
+    {
+        std::uint64_t boundary = (_now | MASK) + 1;
+        unsigned from = static_cast<unsigned>(_now & MASK) + 1;
+        for (unsigned word = from / 64; word < _occupied.size(); ++word) {
+            std::uint64_t bits = _occupied[word];
+            if (word == from / 64) {
+                bits &= ~std::uint64_t(0) << (from % 64);
+            }
+            if (bits != 0) {
+                return (_now & ~std::uint64_t(MASK)) + word * 64
+                    + static_cast<unsigned>(std::countr_zero(bits));
+            }
+        }
+        return boundary;
+    }
+
+    // Двигаем время до target и вызываем fire(topic) для каждого сработавшего
+    // таймера. Пустые промежутки пропускаются целиком.
+    template <typename Fire>
+    void advance(std::uint64_t target, Fire fire)
+    {
+        while (_now < target) {
+            _now = std::min(nextEventTick(), target);
+
+            // Начался новый круг нулевого уровня: осыпаем верхние уровни,
+            // начиная с самого верхнего, который тоже начал новый круг
+            if ((_now & MASK) == 0) {
+                unsigned top = 1;
+                while (top + 1 < LEVELS && ((_now >> (BITS * top)) & MASK) == 0) {
+                    ++top;
+                }
+                for (unsigned level = top; level >= 1; --level) {
+                    cascade(level, static_cast<unsigned>((_now >> (BITS * level)) & MASK));
+                }
+            }
+
+            unsigned slot = static_cast<unsigned>(_now & MASK);
+            std::uint32_t current = _heads[slot];
+            _heads[slot] = NIL;
+            _occupied[slot / 64] &= ~(std::uint64_t(1) << (slot % 64));
+            while (current != NIL) {
+                std::uint32_t next = _nodes[current].next;
+                _nodes[current].linked = false;
+                fire(_nodes[current].topic);
+                // fire() мог вызвать schedule(), берем узел заново
+                Node& node = _nodes[current];
+                if (node.period != 0) {
+                    // Без накопления сдвига: от расчетного времени, а не от now
+                    node.expires += node.period;
+                    if (node.expires <= _now) {
+                        node.expires = _now + node.period;
+                    }
+                    link(current);
+                } else {
+                    release(current);
+                }
+                current = next;
+            }
+        }
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Один поток, который крутит колесо и уведомляет Subject
+// ---------------------------------------------------------------------------
+class TimerService {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Subject& _subject;
+    std::chrono::milliseconds _tick;
+    Clock::time_point _start = Clock::now();
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    TimingWheel _wheel;
+    bool _stopping = false;
+    std::thread _thread;
+
+    std::uint64_t ticksOf(std::chrono::milliseconds duration) const
+    {
+        // Округляем вверх: таймер не должен сработать раньше срока
+        return static_cast<std::uint64_t>((duration + _tick - std::chrono::milliseconds(1)) / _tick);
+    }
+
+    std::uint64_t currentTick() const
+    {
+        return static_cast<std::uint64_t>((Clock::now() - _start) / _tick);
+    }
+
+    void run()
+    {
+        std::vector<int> fired;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_stopping) {
+            if (_wheel.size() == 0) {
+                // Таймеров нет: спим до первого schedule()
+                _cv.wait(lock, [this] { return _stopping || _wheel.size() != 0; });
+                continue;
+            }
+            // Просыпаемся к ближайшему событию колеса или раньше, если
+            // schedule() добавил таймер; потом двигаем колесо до текущего тика
+            auto wakeAt = _start + _tick * _wheel.nextEventTick();
+            _cv.wait_until(lock, wakeAt);
+            if (_stopping) {
+                break;
+            }
+            _wheel.advance(currentTick(), [&fired](int topic) { fired.push_back(topic); });
+
+            // Уведомляем без блокировки, чтобы наблюдатели могли
+            // планировать и отменять таймеры
+            lock.unlock();
+            for (int topic : fired) {
+                _subject.notify(topic);
+            }
+            fired.clear();
+            lock.lock();
+        }
+    }
+
+public:
+    TimerService(Subject& subject,
+        std::size_t capacity = 1 << 20,
+        std::chrono::milliseconds tick = std::chrono::milliseconds(1))
+        : _subject(subject)
+        , _tick(tick)
+        , _wheel(capacity)
+    {
+        _thread = std::thread([this] { run(); });
+    }
+
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    ~TimerService()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _cv.notify_one();
+        _thread.join();
+    }
+
+    // Одноразовое уведомление topic через delay
+    TimerId notifyAfter(int topic, std::chrono::milliseconds delay)
+    {
+        return schedule(topic, delay, std::chrono::milliseconds(0));
+    }
+
+    // Периодическое уведомление topic каждые period, первое через period
+    TimerId notifyEvery(int topic, std::chrono::milliseconds period)
+    {
+        return schedule(topic, period, period);
+    }
+
+    bool cancel(TimerId id)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _wheel.cancel(id);
+    }
+
+private:
+    TimerId schedule(int topic, std::chrono::milliseconds delay,
+        std::chrono::milliseconds period)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // Колесо могло отстать, пока поток спал: считаем от текущего тика
+        std::uint64_t lag = currentTick() - _wheel.now();
+        TimerId id = _wheel.schedule(topic, ticksOf(delay) + lag,
+            static_cast<std::uint32_t>(ticksOf(period)));
+        // Будим поток: новый таймер может быть раньше того, которого он ждет
+        _cv.notify_one();
+        return id;
+    }
+};
+
+int main()
+{
+    Subject subject;
+    subject.addObserver(Subject::DATA, Observer::make("Heartbeat"));
+    subject.addObserver(Subject::LOG, Observer::make("Logger"));
+    std::cout << std::endl;
+
+    {
+        TimerService timers(subject);
+        timers.notifyEvery(Subject::DATA, std::chrono::milliseconds(100));
+        timers.notifyAfter(Subject::LOG, std::chrono::milliseconds(250));
+        TimerId cancelled = timers.notifyAfter(Subject::LOG, std::chrono::milliseconds(300));
+        std::cout << "cancel LOG at 300 ms: " << timers.cancel(cancelled) << std::endl;
+        std::cout << "cancel again: " << timers.cancel(cancelled) << std::endl;
+        // Подписка, пока поток таймеров уже уведомляет Subject
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        subject.addObserver(Subject::LOG, Observer::make("LateLogger"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+
+    // Масштаб: миллион таймеров в колесе без потока, время в тиках
+    constexpr std::size_t TIMERS = 1'000'000;
+    TimingWheel wheel(TIMERS);
+    std::mt19937_64 random(42);
+    std::uniform_int_distribution<std::uint64_t> delays(1, 10'000'000);
+    std::vector<TimerId> ids;
+    ids.reserve(TIMERS);
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < TIMERS; ++i) {
+        ids.push_back(wheel.schedule(Subject::DATA, delays(random)));
+    }
+    double insertNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start)
+                          .count();
+    std::cout << "\nscheduled " << wheel.size() << " timers, "
+              << insertNs / TIMERS << " ns per insert, "
+              << wheel.memoryBytes() / (1024 * 1024) << " MiB" << std::endl;
+    std::cout << "pool full, schedule returns invalid id: "
+              << (wheel.schedule(Subject::DATA, 1) == INVALID_TIMER) << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < TIMERS; i += 2) {
+        wheel.cancel(ids[i]);
+    }
+    double cancelNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start)
+                          .count();
+    std::cout << "cancelled half, " << cancelNs / (TIMERS / 2) << " ns per cancel"
+              << std::endl;
+
+    std::uint64_t fired = 0;
+    start = std::chrono::steady_clock::now();
+    wheel.advance(10'000'000, [&fired](int) { ++fired; });
+    double advanceMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start)
+                           .count();
+    std::cout << "advanced 10M ticks in " << advanceMs << " ms, fired " << fired
+              << ", left " << wheel.size() << std::endl;
+
+    return 0;
+}